@@ -0,0 +1,287 @@
+/*
+ * Host benchmark suite for the portable renderer and the vecmath
+ * reference (make -C host bench). Every result is one JSON object per
+ * line on stdout, so runs can be diffed or fed to a regression check:
+ *
+ *   {"bench":"glyph","variant":"atlas","width":1280,"height":720,
+ *    "scale":2,"ops":100000,"sec":0.0123,"rate":8.1e6,"unit":"glyphs/s",
+ *    "checksum":"0x1234abcd"}
+ *
+ * 'checksum' hashes the framebuffer (or results) after the run, so a
+ * speedup that changes the output shows up too. -q divides the iteration
+ * counts by 10 for a quick smoke run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "benchdata.h"
+#include "fill.h"
+#include "glyph.h"
+#include "headless.h"
+#include "textlayer.h"
+#include "timer.h"
+#include "vecmath.h"
+#include "vecmath_ref.h"
+#include "vecmath_soa.h"
+
+#define HOST_CLEARS     200
+#define HOST_GLYPHS     100000
+#define HOST_STRINGS    20000
+#define HOST_FRAMES     600
+#define HOST_VECTORS    16384
+#define HOST_VEC_RUNS   50
+
+typedef struct {
+    u32 width;
+    u32 height;
+} hostRes;
+
+static const hostRes host_res[] = { { 720, 480 }, { 1280, 720 }, { 1920, 1080 } };
+static const u32 host_scales[] = { 1, 2, 4, 8 };
+
+static u32 iter_div = 1;
+
+static const char host_string[] = "The quick brown fox jumps over the lazy dog";
+
+/* Fixed-seed LCG so every run draws the same positions */
+static u32 rng_state;
+
+static u32 rng(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+/* FNV-1a over 32-bit words */
+static u32 checksum(const u32 *p, u32 words)
+{
+    u32 h = 2166136261u;
+    u32 i;
+
+    for (i = 0; i < words; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static void emit(const char *bench, const char *variant, u32 width, u32 height,
+                 u32 scale, u64 ops, u64 ticks, double per_op, const char *unit,
+                 u32 sum)
+{
+    double sec = timerToSec(ticks);
+
+    printf("{\"bench\":\"%s\",\"variant\":\"%s\",\"width\":%u,\"height\":%u,"
+           "\"scale\":%u,\"ops\":%llu,\"sec\":%.6f,\"rate\":%.6g,\"unit\":\"%s\","
+           "\"checksum\":\"0x%08x\"}\n",
+           bench, variant, width, height, scale, (unsigned long long)ops, sec,
+           sec > 0.0 ? (double)ops * per_op / sec : 0.0, unit, sum);
+    fflush(stdout);
+}
+
+static int makeTarget(glyphTarget *t, u32 width, u32 height)
+{
+    t->width  = width;
+    t->height = height;
+    t->pitch  = width * sizeof(u32);
+    t->offset = 0;
+    t->ptr    = (u32 *)memalign(128, t->pitch * height);
+    if (!t->ptr)
+        return -1;
+    memset(t->ptr, 0, t->pitch * height);
+    return 0;
+}
+
+/* Full-screen background fill through the software back end */
+static void benchClear(const glyphTarget *t)
+{
+    textRect r = { 0, 0, t->width, t->height };
+    u32 n = HOST_CLEARS / iter_div, i;
+    u64 t0 = timerNow();
+
+    for (i = 0; i < n; i++)
+        textBackendSoftware.fill(t, &r, 0x00102040 + i);
+
+    emit("clear", "fill", t->width, t->height, 0, n, timerNow() - t0,
+         (double)t->pitch * t->height / 1e6, "MB/s",
+         checksum(t->ptr, t->width * t->height));
+}
+
+/*
+ * Fill bandwidth of each fill.c path: a colour fill and a zero fill
+ * (FILL_CACHED, so dcbz on a PPC host) over the whole target.
+ */
+static void benchFill(const glyphTarget *t)
+{
+    static const char *variants[2][2] = {
+        { "scalar", "scalar-zero" },
+        { "vector", "vector-zero" },
+    };
+    u32 n = HOST_CLEARS / iter_div, i, p, z;
+
+    for (p = FILL_PATH_SCALAR; p <= FILL_PATH_VECTOR; p++) {
+        fillSetPath(p);
+        for (z = 0; z < 2; z++) {
+            u64 t0 = timerNow();
+
+            for (i = 0; i < n; i++)
+                fillRows(t->ptr, t->pitch, t->width, t->height,
+                         z ? 0 : 0x00102040 + i, FILL_CACHED);
+
+            emit("fill", variants[p][z], t->width, t->height, 0, n, timerNow() - t0,
+                 (double)t->pitch * t->height / 1e6, "MB/s",
+                 checksum(t->ptr, t->width * t->height));
+        }
+    }
+    fillSetPath(FILL_PATH_VECTOR);
+}
+
+/* Glyphs/sec at random on-screen positions, atlas vs. per-pixel plotter */
+static void benchGlyph(const glyphTarget *t, u32 scale, int per_pixel)
+{
+    u32 gw = FONT_W * scale, gh = FONT_H * scale;
+    u32 n = HOST_GLYPHS / iter_div, i;
+    u64 t0;
+
+    memset(t->ptr, 0, t->pitch * t->height);
+    rng_state = 1;
+    t0 = timerNow();
+    for (i = 0; i < n; i++) {
+        u32 x = rng() % (t->width - gw);
+        u32 y = rng() % (t->height - gh);
+        char c = (char)(FONT_FIRST + 1 + i % (FONT_LAST - FONT_FIRST));
+
+        if (per_pixel)
+            glyphDrawCharPerPixel(t, c, x, y, 0x00FFFFFF, scale);
+        else
+            glyphDrawChar(t, c, x, y, 0x00FFFFFF, scale);
+    }
+
+    emit("glyph", per_pixel ? "perpixel" : "atlas", t->width, t->height, scale,
+         n, timerNow() - t0, 1.0, "glyphs/s",
+         checksum(t->ptr, t->width * t->height));
+}
+
+/* Whole strings, one per text line, wrapping back to the top */
+static void benchString(const glyphTarget *t, u32 scale)
+{
+    u32 line = FONT_H * scale + 2;
+    u32 n = HOST_STRINGS / iter_div, i, y = 0;
+    u64 t0;
+
+    memset(t->ptr, 0, t->pitch * t->height);
+    t0 = timerNow();
+    for (i = 0; i < n; i++) {
+        glyphDrawString(t, host_string, 8 + (i & 7), y, 0x0000CC00, scale);
+        y += line;
+        if (y + line > t->height)
+            y = 0;
+    }
+
+    emit("string", "atlas", t->width, t->height, scale, n, timerNow() - t0,
+         (double)(sizeof(host_string) - 1), "chars/s",
+         checksum(t->ptr, t->width * t->height));
+}
+
+/* The demo's frame through the text layer, double-buffered, full vs. dirty */
+static void benchLayer(const glyphTarget *t, textRedrawMode mode)
+{
+    headlessConfig c;
+    headlessResult r;
+
+    memset(&c, 0, sizeof(c));
+    c.width   = t->width;
+    c.height  = t->height;
+    c.frames  = HOST_FRAMES / iter_div;
+    c.buffers = 2;
+    c.mode    = mode;
+    if (headlessRun(&c, &r) != 0)
+        return;
+
+    emit("layer", mode == TEXT_REDRAW_FULL ? "full" : "dirty", t->width, t->height,
+         0, r.frames, r.ticks, 1.0, "frames/s", r.checksum);
+}
+
+/* Reference vecmath kernel over a batch, the same inputs as bench.c */
+static void benchVecmath(void)
+{
+    vecmath_vec_t *v;
+    u32 runs = HOST_VEC_RUNS / iter_div, r;
+    u64 t0;
+
+    v = (vecmath_vec_t *)memalign(128, HOST_VECTORS * sizeof(vecmath_vec_t));
+    if (!v)
+        return;
+
+    benchDataFill(v, HOST_VECTORS, sizeof(vecmath_vec_t), 0, NULL);
+
+    t0 = timerNow();
+    for (r = 0; r < runs; r++)
+        vecmathRefBatch(v, HOST_VECTORS);
+
+    emit("vecmath", "ref", 0, 0, 0, (u64)runs * HOST_VECTORS, timerNow() - t0,
+         1.0, "vectors/s",
+         checksum((const u32 *)v, HOST_VECTORS * sizeof(vecmath_vec_t) / 4));
+    free(v);
+}
+
+/* The same batch as benchVecmath() in SoA planes */
+static void benchVecmathSoa(void)
+{
+    vecmath_soa_t *soa;
+    u32 runs = HOST_VEC_RUNS / iter_div, r, i;
+    u64 t0;
+
+    soa = vecmathSoaAlloc(HOST_VECTORS, VECMATH_SOA_OUT_ALL);
+    if (!soa)
+        return;
+
+    for (i = 0; i < HOST_VECTORS; i++) {
+        vecmathSoaPlane(soa, VECMATH_SOA_X)[i] = 1.0f + (float)(i % 97);
+        vecmathSoaPlane(soa, VECMATH_SOA_Y)[i] = 0.5f * (float)(i % 13);
+        vecmathSoaPlane(soa, VECMATH_SOA_Z)[i] = -2.0f + (float)(i % 7);
+        vecmathSoaPlane(soa, VECMATH_SOA_W)[i] = 0.25f * (float)(i % 31);
+    }
+
+    t0 = timerNow();
+    for (r = 0; r < runs; r++)
+        vecmathRefSoa(soa);
+
+    emit("vecmath", "ref-soa", 0, 0, 0, (u64)runs * HOST_VECTORS, timerNow() - t0,
+         1.0, "vectors/s",
+         checksum((const u32 *)(soa + 1), VECMATH_SOA_PLANES * soa->stride));
+    vecmathSoaFree(soa);
+}
+
+int main(int argc, char *argv[])
+{
+    u32 r, s;
+
+    if (argc > 1 && strcmp(argv[1], "-q") == 0)
+        iter_div = 10;
+
+    for (r = 0; r < sizeof(host_res) / sizeof(host_res[0]); r++) {
+        glyphTarget t;
+
+        if (makeTarget(&t, host_res[r].width, host_res[r].height) != 0) {
+            fprintf(stderr, "hostbench: out of memory\n");
+            return 1;
+        }
+
+        benchClear(&t);
+        benchFill(&t);
+        for (s = 0; s < sizeof(host_scales) / sizeof(host_scales[0]); s++) {
+            benchGlyph(&t, host_scales[s], 0);
+            benchGlyph(&t, host_scales[s], 1);
+            benchString(&t, host_scales[s]);
+        }
+        benchLayer(&t, TEXT_REDRAW_FULL);
+        benchLayer(&t, TEXT_REDRAW_DIRTY);
+        free(t.ptr);
+    }
+
+    benchVecmath();
+    benchVecmathSoa();
+    return 0;
+}
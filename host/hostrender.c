@@ -0,0 +1,128 @@
+/*
+ * Headless render driver (see src/headless.h). Renders the demo frame
+ * into memory for N frames, prints one hostbench-style JSON line with
+ * frames/s, and optionally dumps frames and compares them to goldens:
+ *
+ *   hostrender [-w W] [-h H] [-n frames] [-b buffers] [-m full|dirty]
+ *              [-p scalar|vector] [-d f,f,...] [-o dir] [-g dir] [-r]
+ *
+ * -d picks the frames to dump (-o) and/or compare (-g); -r dumps raw
+ * XRGB words instead of PPM. Exits 1 if any compared frame differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fill.h"
+#include "headless.h"
+#include "timer.h"
+
+#define RENDER_MAX_DUMPS    64
+
+static int cmpU32(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* "0,1,59" -> sorted frame list; returns the count */
+static u32 parseFrames(const char *s, u32 *out)
+{
+    u32 n = 0;
+    char *end;
+
+    while (*s && n < RENDER_MAX_DUMPS) {
+        out[n++] = (u32)strtoul(s, &end, 10);
+        if (end == s)
+            return 0;
+        s = *end == ',' ? end + 1 : end;
+    }
+    qsort(out, n, sizeof(u32), cmpU32);
+    return n;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hostrender [-w W] [-h H] [-n frames] [-b buffers] "
+                    "[-m full|dirty] [-p scalar|vector] [-d f,f,...] [-o dir] [-g dir] [-r]\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    static u32 dump[RENDER_MAX_DUMPS];
+    headlessConfig c;
+    headlessResult r;
+    int i;
+
+    memset(&c, 0, sizeof(c));
+    c.width   = 1280;
+    c.height  = 720;
+    c.frames  = 600;
+    c.buffers = 2;
+    c.mode    = TEXT_REDRAW_DIRTY;
+    c.dump    = dump;
+
+    for (i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (opt[0] != '-' || !opt[1] || opt[2])
+            usage();
+        if (opt[1] == 'r') {
+            c.raw = 1;
+            continue;
+        }
+        if (!val)
+            usage();
+        i++;
+        switch (opt[1]) {
+        case 'w': c.width   = (u32)strtoul(val, NULL, 10); break;
+        case 'h': c.height  = (u32)strtoul(val, NULL, 10); break;
+        case 'n': c.frames  = (u32)strtoul(val, NULL, 10); break;
+        case 'b': c.buffers = (u32)strtoul(val, NULL, 10); break;
+        case 'o': c.dump_dir   = val; break;
+        case 'g': c.golden_dir = val; break;
+        case 'd':
+            if (!(c.dump_count = parseFrames(val, dump)))
+                usage();
+            break;
+        case 'm':
+            if (strcmp(val, "full") == 0)
+                c.mode = TEXT_REDRAW_FULL;
+            else if (strcmp(val, "dirty") == 0)
+                c.mode = TEXT_REDRAW_DIRTY;
+            else
+                usage();
+            break;
+        case 'p':
+            if (strcmp(val, "scalar") == 0)
+                fillSetPath(FILL_PATH_SCALAR);
+            else if (strcmp(val, "vector") == 0)
+                fillSetPath(FILL_PATH_VECTOR);
+            else
+                usage();
+            break;
+        default:
+            usage();
+        }
+    }
+    if (!c.width || !c.height)
+        usage();
+
+    if (headlessRun(&c, &r) != 0) {
+        fprintf(stderr, "hostrender: out of memory\n");
+        return 1;
+    }
+
+    printf("{\"bench\":\"headless\",\"variant\":\"%s-%s\",\"width\":%u,\"height\":%u,"
+           "\"buffers\":%u,\"ops\":%u,\"sec\":%.6f,\"rate\":%.6g,\"unit\":\"frames/s\","
+           "\"checksum\":\"0x%08x\",\"dumped\":%u,\"compared\":%u,\"mismatched\":%u}\n",
+           c.mode == TEXT_REDRAW_FULL ? "full" : "dirty",
+           fillGetPath() == FILL_PATH_VECTOR ? "vector" : "scalar",
+           c.width, c.height, c.buffers, r.frames, timerToSec(r.ticks), r.fps,
+           r.checksum, r.dumped, r.compared, r.mismatched);
+    return r.mismatched ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * Replay trace and frame-time tools (see src/replay.h):
+ *
+ *   hostreplay info trace.bin          one JSON line: size, frames, events
+ *   hostreplay csv trace.bin           the recorded frame times as CSV
+ *   hostreplay cmp a.csv b.csv [-t pct]
+ *
+ * cmp reads two frame-time CSVs (from replays of one trace by two builds,
+ * or from 'csv'), pairs them frame by frame and prints one hostbench-style
+ * JSON line per column: mean/p50/p99/max of each side, the change of the
+ * mean in percent, and how many frames got slower or faster than pct.
+ * Exits 1 if b's mean frame_us or busy_us is more than pct (default 5)
+ * percent above a's.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+
+#define CMP_DEFAULT_PCT 5.0
+
+/* Columns of a frame-time CSV that cmp looks at */
+enum { COL_FRAME_US, COL_WAIT_US, COL_BUSY_US, COL_COUNT };
+
+static const char *col_names[COL_COUNT] = { "frame_us", "wait_us", "busy_us" };
+
+typedef struct {
+    u32     frames;
+    double *col[COL_COUNT];
+} frameTimes;
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hostreplay info trace.bin\n"
+                    "       hostreplay csv trace.bin\n"
+                    "       hostreplay cmp a.csv b.csv [-t pct]\n");
+    exit(2);
+}
+
+static void loadTrace(const char *path, replayTrace *t)
+{
+    if (replayTraceLoad(path, t) != 0) {
+        fprintf(stderr, "hostreplay: %s is not a replay trace\n", path);
+        exit(1);
+    }
+}
+
+static int info(const char *path)
+{
+    u32 kinds[REPLAY_FRAME + 1] = { 0 };
+    replayTrace t;
+    double sec = 0.0;
+    u32 i;
+
+    loadTrace(path, &t);
+    for (i = 0; i < t.count; i++) {
+        if (t.records[i].kind <= REPLAY_FRAME)
+            kinds[t.records[i].kind]++;
+        if (t.records[i].kind == REPLAY_FRAME)
+            sec += (double)t.records[i].v0 / t.timebase;
+    }
+
+    printf("{\"trace\":\"%s\",\"width\":%u,\"height\":%u,\"buffers\":%u,\"timebase\":%llu,"
+           "\"frames\":%u,\"sec\":%.6f,\"pad\":%u,\"sysutil\":%u,\"spe\":%u}\n",
+           path, t.width, t.height, t.buffers, (unsigned long long)t.timebase,
+           t.frames, sec, kinds[REPLAY_PAD], kinds[REPLAY_SYSUTIL], kinds[REPLAY_SPE]);
+    replayTraceFree(&t);
+    return 0;
+}
+
+/* Same columns as a replay's CSV, the recording standing in for both runs */
+static int csv(const char *path)
+{
+    replayTrace t;
+    u32 i, frame = 0;
+
+    loadTrace(path, &t);
+    printf("frame,frame_us,wait_us,busy_us,recorded_us,recorded_wait_us\n");
+    for (i = 0; i < t.count; i++) {
+        const replayRecord *r = &t.records[i];
+        double us, wait_us;
+
+        if (r->kind != REPLAY_FRAME)
+            continue;
+        us      = r->v0 * 1e6 / t.timebase;
+        wait_us = r->v1 * 1e6 / t.timebase;
+        printf("%u,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+               frame++, us, wait_us, us - wait_us, us, wait_us);
+    }
+    replayTraceFree(&t);
+    return 0;
+}
+
+static void loadCsv(const char *path, frameTimes *ft)
+{
+    char line[256];
+    u32 cap = 0, c;
+    FILE *f;
+
+    memset(ft, 0, sizeof(*ft));
+    if ((f = fopen(path, "r")) == NULL || !fgets(line, sizeof(line), f) ||
+        strncmp(line, "frame,frame_us,wait_us,busy_us", 30) != 0) {
+        fprintf(stderr, "hostreplay: %s is not a frame-time CSV\n", path);
+        exit(1);
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        unsigned int frame;
+        double v[COL_COUNT];
+
+        if (sscanf(line, "%u,%lf,%lf,%lf", &frame, &v[0], &v[1], &v[2]) != 4)
+            continue;
+        if (ft->frames == cap) {
+            cap = cap ? 2 * cap : 4096;
+            for (c = 0; c < COL_COUNT; c++) {
+                ft->col[c] = (double *)realloc(ft->col[c], cap * sizeof(double));
+                if (!ft->col[c]) {
+                    fprintf(stderr, "hostreplay: out of memory\n");
+                    exit(1);
+                }
+            }
+        }
+        for (c = 0; c < COL_COUNT; c++)
+            ft->col[c][ft->frames] = v[c];
+        ft->frames++;
+    }
+    fclose(f);
+}
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+typedef struct {
+    double mean, p50, p99, max;
+} colSummary;
+
+static void summarize(const double *v, u32 n, colSummary *s)
+{
+    double *sorted = (double *)malloc((n ? n : 1) * sizeof(double));
+    double sum = 0.0;
+    u32 i;
+
+    memset(s, 0, sizeof(*s));
+    if (!sorted || !n) {
+        free(sorted);
+        return;
+    }
+    memcpy(sorted, v, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), cmpDouble);
+    for (i = 0; i < n; i++)
+        sum += sorted[i];
+    s->mean = sum / n;
+    s->p50  = sorted[n / 2];
+    s->p99  = sorted[(u32)((n - 1) * 0.99)];
+    s->max  = sorted[n - 1];
+    free(sorted);
+}
+
+static int cmp(const char *path_a, const char *path_b, double pct)
+{
+    frameTimes a, b;
+    int regressed = 0;
+    u32 n, c, i;
+
+    loadCsv(path_a, &a);
+    loadCsv(path_b, &b);
+    /* A replay that was stopped early compares over the frames both have */
+    n = a.frames < b.frames ? a.frames : b.frames;
+    if (a.frames != b.frames)
+        fprintf(stderr, "hostreplay: %u vs %u frames, comparing the first %u\n",
+                a.frames, b.frames, n);
+
+    for (c = 0; c < COL_COUNT; c++) {
+        colSummary sa, sb;
+        u32 slower = 0, faster = 0;
+        double delta;
+
+        summarize(a.col[c], n, &sa);
+        summarize(b.col[c], n, &sb);
+        for (i = 0; i < n; i++) {
+            if (b.col[c][i] > a.col[c][i] * (1.0 + pct / 100.0))
+                slower++;
+            else if (b.col[c][i] < a.col[c][i] * (1.0 - pct / 100.0))
+                faster++;
+        }
+        delta = sa.mean > 0.0 ? 100.0 * (sb.mean - sa.mean) / sa.mean : 0.0;
+        /* wait_us is what the flip left over: it shrinks as the rest grows */
+        if (c != COL_WAIT_US && delta > pct)
+            regressed = 1;
+
+        printf("{\"bench\":\"replay\",\"variant\":\"%s\",\"frames\":%u,"
+               "\"a_mean\":%.1f,\"a_p50\":%.1f,\"a_p99\":%.1f,\"a_max\":%.1f,"
+               "\"b_mean\":%.1f,\"b_p50\":%.1f,\"b_p99\":%.1f,\"b_max\":%.1f,"
+               "\"unit\":\"us\",\"delta_pct\":%.2f,\"slower\":%u,\"faster\":%u}\n",
+               col_names[c], n, sa.mean, sa.p50, sa.p99, sa.max,
+               sb.mean, sb.p50, sb.p99, sb.max, delta, slower, faster);
+    }
+
+    for (c = 0; c < COL_COUNT; c++) {
+        free(a.col[c]);
+        free(b.col[c]);
+    }
+    return regressed;
+}
+
+int main(int argc, char *argv[])
+{
+    double pct = CMP_DEFAULT_PCT;
+
+    if (argc == 3 && strcmp(argv[1], "info") == 0)
+        return info(argv[2]);
+    if (argc == 3 && strcmp(argv[1], "csv") == 0)
+        return csv(argv[2]);
+    if (argc >= 4 && strcmp(argv[1], "cmp") == 0) {
+        if (argc == 6 && strcmp(argv[4], "-t") == 0)
+            pct = strtod(argv[5], NULL);
+        else if (argc != 4)
+            usage();
+        return cmp(argv[2], argv[3], pct);
+    }
+    usage();
+    return 2;
+}
@@ -0,0 +1,19 @@
+#ifndef __PPU_TYPES_H__
+#define __PPU_TYPES_H__
+
+/*
+ * Host stand-in for PSL1GHT's <ppu-types.h>: the fixed-width types the
+ * portable PPU sources (glyph.c, textlayer.c, vecmath_ref.c) use.
+ */
+#include <stdint.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+#endif
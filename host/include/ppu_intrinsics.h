@@ -0,0 +1,20 @@
+#ifndef __PPU_INTRINSICS_H__
+#define __PPU_INTRINSICS_H__
+
+/*
+ * Host stand-in for __mftb(): a monotonic nanosecond clock, so timer.h
+ * works unchanged (see sys/systime.h for the matching frequency).
+ */
+#include <time.h>
+
+#include <ppu-types.h>
+
+static inline u64 __mftb(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __SYS_SYSTIME_H__
+#define __SYS_SYSTIME_H__
+
+#include <ppu-types.h>
+
+/* The host __mftb() counts nanoseconds */
+static inline u64 sysGetTimebaseFrequency(void)
+{
+    return 1000000000ULL;
+}
+
+#endif
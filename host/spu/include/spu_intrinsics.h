@@ -0,0 +1,108 @@
+#ifndef __SPU_INTRINSICS_H__
+#define __SPU_INTRINSICS_H__
+
+/*
+ * Host stand-in for the SPU intrinsics the kernels in spu/source use, so
+ * the same kernel sources build natively (see host/spu/spusim.c).
+ *
+ * 'vector T' becomes a GCC 16-byte vector of T, which keeps the SPU
+ * element order (element 0 at the lowest address). Arithmetic is plain
+ * vector-extension code the compiler maps to SSE/NEON; spu_rsqrte uses
+ * the hardware estimate where there is one. Results follow the host's
+ * IEEE rounding, not the SPU's (single precision truncates and flushes
+ * denormals there), so ULP figures differ slightly from the console.
+ */
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define vector __attribute__((vector_size(16)))
+
+typedef vector float            vec_float4;
+typedef vector signed int       vec_int4;
+typedef vector unsigned int     vec_uint4;
+typedef vector unsigned char    vec_uchar16;
+
+/* Replicate a scalar; the element type follows the argument, as on the SPU */
+#define spu_splats(x) _Generic((x),                                     \
+    float:        (vec_float4){ (x), (x), (x), (x) },                   \
+    int:          (vec_int4){ (x), (x), (x), (x) },                     \
+    unsigned int: (vec_uint4){ (x), (x), (x), (x) })
+
+#define spu_extract(v, i)   ((v)[(i) & (16 / sizeof((v)[0]) - 1)])
+
+#define spu_add(a, b)       ((a) + (b))
+#define spu_sub(a, b)       ((a) - (b))
+#define spu_mul(a, b)       ((a) * (b))
+#define spu_madd(a, b, c)   ((a) * (b) + (c))
+#define spu_msub(a, b, c)   ((a) * (b) - (c))
+#define spu_nmsub(a, b, c)  ((c) - (a) * (b))
+
+/* Comparisons give all-ones / all-zero element masks */
+#define spu_cmpeq(a, b)     ((vec_uint4)((a) == (b)))
+#define spu_cmpgt(a, b)     ((vec_uint4)((a) > (b)))
+
+#define spu_and(a, b)       ((a) & (b))
+#define spu_or(a, b)        ((a) | (b))
+#define spu_andc(a, b)      ((a) & ~(b))
+
+/* Bits of 'b' where 'm' is set, of 'a' elsewhere, for any 16-byte type */
+#define spu_sel(a, b, m)                                                \
+    ((__typeof__(a))(((vec_uint4)(a) & ~(vec_uint4)(m)) |               \
+                     ((vec_uint4)(b) & (vec_uint4)(m))))
+
+/* Rotate the quadword left by 'n' bytes (byte i <- byte i + n) */
+static inline vec_uchar16 spu_rlqwbyte(vec_uchar16 v, int n)
+{
+    unsigned char b[32];
+    vec_uchar16 r;
+
+    /* Two copies back to back: the rotation is a 16-byte window into them */
+    memcpy(b, &v, 16);
+    memcpy(b + 16, &v, 16);
+    memcpy(&r, b + (n & 15), 16);
+    return r;
+}
+
+/* Reciprocal square root estimate, ~12 bits like frsqest */
+static inline vec_float4 spu_rsqrte(vec_float4 x)
+{
+#if defined(__SSE__)
+    vec_float4 r;
+    __m128 m;
+
+    memcpy(&m, &x, sizeof(m));
+    m = _mm_rsqrt_ps(m);
+    memcpy(&r, &m, sizeof(r));
+    return r;
+#elif defined(__ARM_NEON)
+    /* vrsqrteq gives 8 bits; one step brings it to the SPU's ~12+ */
+    float32x4_t v = vld1q_f32((const float *)&x);
+    float32x4_t e = vrsqrteq_f32(v);
+    vec_float4 r;
+
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(v, e), e));
+    vst1q_f32((float *)&r, e);
+    return r;
+#else
+    vec_float4 r;
+    int i;
+
+    for (i = 0; i < 4; i++)
+        r[i] = 1.0f / sqrtf(x[i]);
+    return r;
+#endif
+}
+
+/* Instruction fetch sync: nothing to do for code that is never copied */
+static inline void spu_sync(void)
+{
+}
+
+#endif
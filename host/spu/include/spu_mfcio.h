@@ -0,0 +1,76 @@
+#ifndef __SPU_MFCIO_H__
+#define __SPU_MFCIO_H__
+
+/*
+ * Host stand-in for the MFC and channel interface. Every DMA is checked
+ * against the MFC rules (size 1, 2, 4, 8 or a multiple of 16 up to
+ * 16 KB; LS and EA with the same offset in the quadword, naturally
+ * aligned below 16 bytes; atomics on whole 128-byte lines; lists checked
+ * element by element) and done at
+ * once with memcpy, so a tag wait only has to report the mask back. EAs
+ * are 32-bit addresses in the simulator's map (spusim_map), as on the
+ * console. A rule violation aborts, like the DMA alignment interrupt.
+ */
+#include <stdint.h>
+
+#define MFC_TAG_UPDATE_IMMEDIATE    0
+#define MFC_TAG_UPDATE_ANY          1
+#define MFC_TAG_UPDATE_ALL          2
+
+#define MFC_PUTLLC_STATUS           1
+
+/* DMA list element; the fields, not the bit layout, match the SDK's */
+typedef struct mfc_list_element {
+    uint64_t notify   : 1;
+    uint64_t reserved : 16;
+    uint64_t size     : 15;
+    uint64_t eal      : 32;
+} mfc_list_element_t;
+
+void     spusim_get(volatile void *ls, uint64_t ea, uint32_t size, uint32_t tag);
+void     spusim_put(volatile void *ls, uint64_t ea, uint32_t size, uint32_t tag);
+void     spusim_getl(volatile void *ls, uint64_t ea, const volatile void *list,
+                     uint32_t list_size, uint32_t tag);
+void     spusim_putl(volatile void *ls, uint64_t ea, const volatile void *list,
+                     uint32_t list_size, uint32_t tag);
+void     spusim_getllar(volatile void *ls, uint64_t ea);
+void     spusim_putllc(volatile void *ls, uint64_t ea);
+uint32_t spusim_read_atomic_status(void);
+uint32_t spusim_tag_status(uint32_t type);
+uint32_t spusim_read_in_mbox(void);
+void     spusim_write_out_mbox(uint32_t v);
+void     spusim_write_out_intr_mbox(uint32_t v);
+uint32_t spusim_read_decrementer(void);
+void     spusim_write_decrementer(uint32_t v);
+
+extern uint32_t spusim_tag_mask;
+
+/* Barrier and fence variants: transfers complete in order anyway */
+#define mfc_get(ls, ea, size, tag, tid, rid)    spusim_get((ls), (ea), (size), (tag))
+#define mfc_getb(ls, ea, size, tag, tid, rid)   spusim_get((ls), (ea), (size), (tag))
+#define mfc_getf(ls, ea, size, tag, tid, rid)   spusim_get((ls), (ea), (size), (tag))
+#define mfc_put(ls, ea, size, tag, tid, rid)    spusim_put((ls), (ea), (size), (tag))
+#define mfc_putb(ls, ea, size, tag, tid, rid)   spusim_put((ls), (ea), (size), (tag))
+#define mfc_putf(ls, ea, size, tag, tid, rid)   spusim_put((ls), (ea), (size), (tag))
+
+#define mfc_getl(ls, ea, list, size, tag, tid, rid)     spusim_getl((ls), (ea), (list), (size), (tag))
+#define mfc_getlb(ls, ea, list, size, tag, tid, rid)    spusim_getl((ls), (ea), (list), (size), (tag))
+#define mfc_getlf(ls, ea, list, size, tag, tid, rid)    spusim_getl((ls), (ea), (list), (size), (tag))
+#define mfc_putl(ls, ea, list, size, tag, tid, rid)     spusim_putl((ls), (ea), (list), (size), (tag))
+#define mfc_putlb(ls, ea, list, size, tag, tid, rid)    spusim_putl((ls), (ea), (list), (size), (tag))
+#define mfc_putlf(ls, ea, list, size, tag, tid, rid)    spusim_putl((ls), (ea), (list), (size), (tag))
+
+#define mfc_getllar(ls, ea, tid, rid)   spusim_getllar((ls), (ea))
+#define mfc_putllc(ls, ea, tid, rid)    spusim_putllc((ls), (ea))
+#define mfc_read_atomic_status()        spusim_read_atomic_status()
+
+#define mfc_write_tag_mask(mask)        (spusim_tag_mask = (mask))
+#define spu_mfcstat(type)               spusim_tag_status(type)
+
+#define spu_read_in_mbox()              spusim_read_in_mbox()
+#define spu_write_out_mbox(v)           spusim_write_out_mbox(v)
+#define spu_write_out_intr_mbox(v)      spusim_write_out_intr_mbox(v)
+#define spu_read_decrementer()          spusim_read_decrementer()
+#define spu_write_decrementer(v)        spusim_write_decrementer(v)
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __SYS_SPU_THREAD_H__
+#define __SYS_SPU_THREAD_H__
+
+/* Host stand-in: the kernel's main() returns to the simulator instead */
+#include <stdint.h>
+
+void spu_thread_exit(uint32_t status);
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * In-process SPU simulator (see spusim.h): EA map, DMA checks, mailboxes,
+ * decrementer and the overlay table the shimmed kernels link against.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+#include <sys/spu_thread.h>
+
+#include "vecmath.h"
+#include "spu_common.h"
+#include "spusim.h"
+
+/* The SPU decrementer runs at the PPU time base, 79.8 MHz on retail units */
+#define SPUSIM_DEC_HZ   79800000ULL
+
+typedef struct {
+    uint8_t *ptr;
+    uint32_t ea;
+    uint32_t size;
+} region_t;
+
+static region_t       regions[SPUSIM_MAX_REGIONS];
+static unsigned int   nregions;
+static uint32_t       next_ea = SPUSIM_EA_BASE;
+
+static uint32_t       mbox[SPUSIM_MBOX_SIZE];
+static unsigned int   mbox_head, mbox_tail;
+
+static uint32_t       atomic_status;
+static uint32_t       dec_start;
+static uint64_t       dec_t0;
+static spusim_stats_t stats;
+
+uint32_t spusim_tag_mask;
+
+/* Exported by SPU_OVERLAY() in tiles.c and soa.c under SPU_HOST */
+extern const spu_kernel_fn spu_host_overlay_run_tiles;
+extern const spu_kernel_fn spu_host_overlay_run_soa;
+
+int spu_main(uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3);
+
+static void fail(const char *what, uint64_t ea, uint32_t size, const volatile void *ls)
+{
+    fprintf(stderr, "spusim: %s (ea 0x%llx, size %u, ls %p)\n",
+            what, (unsigned long long)ea, size, (const void *)ls);
+    abort();
+}
+
+void spusim_reset(void)
+{
+    nregions  = 0;
+    next_ea   = SPUSIM_EA_BASE;
+    mbox_head = mbox_tail = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t spusim_map(void *p, size_t size)
+{
+    region_t *r;
+
+    if (nregions == SPUSIM_MAX_REGIONS || ((uintptr_t)p & 127) ||
+        (uint64_t)next_ea + size > 0xffffffffULL)
+        fail("can't map region", next_ea, (uint32_t)size, p);
+
+    r = &regions[nregions++];
+    r->ptr  = (uint8_t *)p;
+    r->ea   = next_ea;
+    r->size = (uint32_t)size;
+    /* Keep the next region's EA on a 128-byte line, with a gap between */
+    next_ea = (uint32_t)((next_ea + size + 128 + 127) & ~127ULL);
+    return r->ea;
+}
+
+void *spusim_ptr(uint64_t ea, size_t size)
+{
+    unsigned int i;
+
+    for (i = 0; i < nregions; i++) {
+        region_t *r = &regions[i];
+
+        if (ea >= r->ea && ea + size <= (uint64_t)r->ea + r->size)
+            return r->ptr + (ea - r->ea);
+    }
+    fail("EA outside mapped memory", ea, (uint32_t)size, NULL);
+    return NULL;
+}
+
+/* The MFC's rules for one transfer */
+static void check_dma(const volatile void *ls, uint64_t ea, uint32_t size, uint32_t tag)
+{
+    uintptr_t l = (uintptr_t)ls;
+
+    if (tag > 31)
+        fail("tag out of range", ea, size, ls);
+    if (size == 0 || size > SPUSIM_DMA_MAX)
+        fail("DMA size out of range", ea, size, ls);
+    if (size < 16) {
+        if (size != 1 && size != 2 && size != 4 && size != 8)
+            fail("DMA size not 1, 2, 4, 8 or a multiple of 16", ea, size, ls);
+        if ((l & (size - 1)) || (ea & (size - 1)))
+            fail("small DMA not naturally aligned", ea, size, ls);
+        if ((l & 15) != (ea & 15))
+            fail("small DMA with different LS/EA quadword offsets", ea, size, ls);
+    } else if ((size & 15) || (l & 15) || (ea & 15)) {
+        fail("DMA not quadword aligned", ea, size, ls);
+    }
+}
+
+void spusim_get(volatile void *ls, uint64_t ea, uint32_t size, uint32_t tag)
+{
+    check_dma(ls, ea, size, tag);
+    memcpy((void *)ls, spusim_ptr(ea, size), size);
+    stats.gets++;
+    stats.get_bytes += size;
+}
+
+void spusim_put(volatile void *ls, uint64_t ea, uint32_t size, uint32_t tag)
+{
+    check_dma(ls, ea, size, tag);
+    memcpy(spusim_ptr(ea, size), (const void *)ls, size);
+    stats.puts++;
+    stats.put_bytes += size;
+}
+
+/*
+ * A list command: each element moves 'size' bytes between the next LS
+ * address and (ea's upper word | eal), under the same rules as a single
+ * transfer. The list itself lives in LS, 8-byte aligned.
+ */
+static void list_dma(volatile void *ls, uint64_t ea, const volatile void *list,
+                     uint32_t list_size, uint32_t tag, int put)
+{
+    const volatile mfc_list_element_t *e = (const volatile mfc_list_element_t *)list;
+    volatile uint8_t *l = (volatile uint8_t *)ls;
+    uint32_t i, n = list_size / sizeof(mfc_list_element_t);
+
+    if (((uintptr_t)list & 7) || (list_size & 7) || n == 0 || n > SPUSIM_LIST_MAX)
+        fail("bad DMA list", ea, list_size, list);
+
+    for (i = 0; i < n; i++) {
+        uint64_t eai  = (ea & 0xffffffff00000000ULL) | e[i].eal;
+        uint32_t size = (uint32_t)e[i].size;
+
+        if (e[i].notify)
+            fail("DMA list stall-and-notify not simulated", eai, size, l);
+        check_dma(l, eai, size, tag);
+        if (put)
+            memcpy(spusim_ptr(eai, size), (const void *)l, size);
+        else
+            memcpy((void *)l, spusim_ptr(eai, size), size);
+        l += size;
+    }
+
+    stats.list_elements += n;
+    if (put) {
+        stats.puts++;
+        stats.put_bytes += (uint64_t)(l - (volatile uint8_t *)ls);
+    } else {
+        stats.gets++;
+        stats.get_bytes += (uint64_t)(l - (volatile uint8_t *)ls);
+    }
+}
+
+void spusim_getl(volatile void *ls, uint64_t ea, const volatile void *list,
+                 uint32_t list_size, uint32_t tag)
+{
+    list_dma(ls, ea, list, list_size, tag, 0);
+}
+
+void spusim_putl(volatile void *ls, uint64_t ea, const volatile void *list,
+                 uint32_t list_size, uint32_t tag)
+{
+    list_dma(ls, ea, list, list_size, tag, 1);
+}
+
+/* A single SPU never loses a reservation, so putllc always succeeds */
+void spusim_getllar(volatile void *ls, uint64_t ea)
+{
+    if (((uintptr_t)ls & 127) || (ea & 127))
+        fail("getllar not on a 128-byte line", ea, 128, ls);
+    memcpy((void *)ls, spusim_ptr(ea, 128), 128);
+    atomic_status = 0;
+    stats.atomics++;
+}
+
+void spusim_putllc(volatile void *ls, uint64_t ea)
+{
+    if (((uintptr_t)ls & 127) || (ea & 127))
+        fail("putllc not on a 128-byte line", ea, 128, ls);
+    memcpy(spusim_ptr(ea, 128), (const void *)ls, 128);
+    atomic_status = 0;
+    stats.atomics++;
+}
+
+uint32_t spusim_read_atomic_status(void)
+{
+    return atomic_status;
+}
+
+/* Every transfer is already complete */
+uint32_t spusim_tag_status(uint32_t type)
+{
+    (void)type;
+    return spusim_tag_mask;
+}
+
+uint32_t spusim_read_in_mbox(void)
+{
+    /* On the SPU this would block forever */
+    if (mbox_tail == mbox_head)
+        fail("read from an empty inbound mailbox", 0, 0, NULL);
+    return mbox[mbox_tail++ % SPUSIM_MBOX_SIZE];
+}
+
+void spusim_write_out_mbox(uint32_t v)
+{
+    stats.last_out_mbox = v;
+}
+
+void spusim_write_out_intr_mbox(uint32_t v)
+{
+    stats.last_event = v;
+    stats.events++;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t spusim_read_decrementer(void)
+{
+    return dec_start - (uint32_t)((now_ns() - dec_t0) * SPUSIM_DEC_HZ / 1000000000ULL);
+}
+
+void spusim_write_decrementer(uint32_t v)
+{
+    dec_start = v;
+    dec_t0    = now_ns();
+}
+
+void spu_thread_exit(uint32_t status)
+{
+    (void)status;
+}
+
+/* Overlays are linked in: "loading" one is a table lookup */
+void overlay_init(uint64_t ea_table)
+{
+    (void)ea_table;
+}
+
+spu_kernel_fn overlay_load(unsigned int id)
+{
+    stats.overlay_loads++;
+    switch (id) {
+    case VECMATH_OVERLAY_TILES: return spu_host_overlay_run_tiles;
+    case VECMATH_OVERLAY_SOA:   return spu_host_overlay_run_soa;
+    default:                    return 0;
+    }
+}
+
+static void push(uint32_t v)
+{
+    if (mbox_head - mbox_tail >= SPUSIM_MBOX_SIZE)
+        fail("inbound mailbox overflow", 0, 0, NULL);
+    mbox[mbox_head++ % SPUSIM_MBOX_SIZE] = v;
+}
+
+void spusim_submit(uint32_t cmd, uint32_t ea, uint32_t size)
+{
+    push(cmd);
+    push(ea);
+    push(size);
+}
+
+void spusim_run_worker(uint32_t ea_status)
+{
+    /* Thread 0 of the group: main() finds its status quadword at arg0 */
+    push(VECMATH_JOB_CMD(VECMATH_KERNEL_QUIT, 0));
+    spu_main(ea_status, 0, 0, VECMATH_MODE_WORKER);
+}
+
+const spusim_stats_t *spusim_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,60 @@
+#ifndef __SPUSIM_H__
+#define __SPUSIM_H__
+
+/*
+ * In-process SPU simulator for the kernel sources in spu/source, built
+ * against the shim headers in host/spu/include.
+ *
+ * Main memory: host buffers are given 32-bit EAs with spusim_map(), and
+ * every DMA is bounds-checked against the region its EA falls in. The
+ * kernel's static buffers play the local store (their total is what the
+ * SPU image would need); DMAs are checked for the MFC size and alignment
+ * rules.
+ *
+ * The kernel's main() (compiled as spu_main) runs on the calling thread:
+ * queue jobs in the inbound mailbox with spusim_submit(), then call
+ * spusim_run_worker(), which returns once it reads the quit command.
+ * One simulated SPU at a time: the kernels' statics are its LS.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPUSIM_DMA_MAX      16384
+#define SPUSIM_LIST_MAX     2048        /* elements per DMA list */
+#define SPUSIM_MAX_REGIONS  16
+#define SPUSIM_MBOX_SIZE    256         /* inbound words queued ahead */
+#define SPUSIM_EA_BASE      0x10000000  /* first EA handed out */
+
+typedef struct {
+    uint64_t gets, puts;            /* DMA commands, a list counting once */
+    uint64_t get_bytes, put_bytes;
+    uint64_t list_elements;         /* transfers done by getl/putl */
+    uint64_t atomics;               /* getllar + putllc */
+    uint64_t events;                /* throw_event (outbound interrupt mailbox) */
+    uint64_t overlay_loads;
+    uint32_t last_event;            /* outbound interrupt mailbox word */
+    uint32_t last_out_mbox;         /* outbound mailbox word (event data1) */
+} spusim_stats_t;
+
+/* Forget every mapping, queued mailbox word and counter */
+void spusim_reset(void);
+
+/* Give [p, p + size) a 32-bit EA; 'p' must be 128-byte aligned */
+uint32_t spusim_map(void *p, size_t size);
+
+/* Host pointer behind an EA, for checks; aborts if unmapped */
+void *spusim_ptr(uint64_t ea, size_t size);
+
+/* Queue one job (three inbound mailbox words, see vecmath.h) */
+void spusim_submit(uint32_t cmd, uint32_t ea, uint32_t size);
+
+/*
+ * Queue the quit command and run the worker loop until it reads it.
+ * 'ea_status' is the mapped vecmath_status_t that VECMATH_JOB_STATUS
+ * jobs report to (0 if none of them does).
+ */
+void spusim_run_worker(uint32_t ea_status);
+
+const spusim_stats_t *spusim_stats(void);
+
+#endif
@@ -0,0 +1,531 @@
+/*
+ * The SPU kernels from spu/source, built natively against the shim in
+ * host/spu (make -C host spubench). Runs every kernel through the worker
+ * loop, checks the results against the PPU reference and the software
+ * renderer, and prints hostbench-style JSON lines:
+ *
+ *   {"bench":"spu","variant":"batch-128","ops":819200,"sec":0.0042,
+ *    "rate":1.9e8,"unit":"vectors/s","checksum":"0x1234abcd",
+ *    "maxerr":3.1e-04,"dma":6400,"ok":1}
+ *
+ * 'dma' counts the simulated MFC commands. The shim aborts on a DMA that
+ * would fault on the MFC; a wrong result sets "ok":0 and the exit status
+ * to 1. -q divides the run counts by 10.
+ *
+ * Rates measure the kernel code on this CPU, not an SPU: DMA is a memcpy
+ * that completes at once, so they say nothing about transfer overlap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "benchdata.h"
+#include "fill.h"
+#include "glyph.h"
+#include "timer.h"
+#include "spudraw.h"
+#include "vecmath.h"
+#include "vecmath_gather.h"
+#include "vecmath_ref.h"
+#include "vecmath_soa.h"
+#include "spu/spusim.h"
+
+#define SPU_VECTORS     16384
+#define SPU_RUNS        50      /* jobs per timed run; 3 mailbox words each */
+#define SPU_FRAMES      20
+#define SPU_FB_W        1280
+#define SPU_FB_H        720
+
+static u32 iter_div = 1;
+static u32 failures;
+
+static vecmath_status_t status __attribute__((aligned(128)));
+static u32 ea_status;
+
+/* FNV-1a over 32-bit words */
+static u32 checksum(const u32 *p, u32 words)
+{
+    u32 h = 2166136261u;
+    u32 i;
+
+    for (i = 0; i < words; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static u64 dmaCount(void)
+{
+    const spusim_stats_t *s = spusim_stats();
+
+    return s->gets + s->puts + s->atomics;
+}
+
+static void emit(const char *variant, u64 ops, u64 ticks, const char *unit,
+                 u32 sum, double maxerr, int ok)
+{
+    double sec = timerToSec(ticks);
+
+    if (!ok)
+        failures++;
+    printf("{\"bench\":\"spu\",\"variant\":\"%s\",\"ops\":%llu,\"sec\":%.6f,"
+           "\"rate\":%.6g,\"unit\":\"%s\",\"checksum\":\"0x%08x\",\"maxerr\":%.3g,"
+           "\"dma\":%llu,\"ok\":%d}\n",
+           variant, (unsigned long long)ops, sec, sec > 0.0 ? (double)ops / sec : 0.0,
+           unit, sum, maxerr, (unsigned long long)dmaCount(), ok);
+    fflush(stdout);
+}
+
+/* Start a fresh simulated SPU with the status quadword mapped */
+static void spuReset(void)
+{
+    spusim_reset();
+    memset(&status, 0, sizeof(status));
+    ea_status = spusim_map(&status, sizeof(status));
+}
+
+/* The worker run reported 'jobs' jobs, the last one of 'kernel' */
+static int statusOk(u32 jobs, u32 kernel)
+{
+    return status.seq == jobs && status.kernel == kernel;
+}
+
+static void fillVecs(vecmath_vec_t *v, u32 count)
+{
+    benchDataFill(v, count, sizeof(vecmath_vec_t), 0, NULL);
+}
+
+/* Kernel SINGLE: one vecmath_data_t, the demo's first job */
+static void benchSingle(void)
+{
+    static vecmath_data_t d __attribute__((aligned(128)));
+    float err = 0.0f;
+    u32 ea;
+    u64 t0;
+    int ok;
+
+    spuReset();
+    memset(&d, 0, sizeof(d));
+    d.input[0] = 1.0f;
+    d.input[1] = 2.0f;
+    d.input[2] = 3.0f;
+    d.input[3] = 4.0f;
+    ea = spusim_map(&d, sizeof(d));
+
+    t0 = timerNow();
+    spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_SINGLE, 0) | VECMATH_JOB_STATUS, ea, 1);
+    spusim_run_worker(ea_status);
+
+    ok = statusOk(1, VECMATH_KERNEL_SINGLE) && d.done == 1 &&
+         d.output[0] == 1.0f && d.output[1] == 4.0f &&
+         d.output[2] == 9.0f && d.output[3] == 16.0f && d.dot_product == 30.0f;
+    err = (d.magnitude - 5.4772256f) / 5.4772256f;
+    if (err < 0.0f)
+        err = -err;
+    ok = ok && err < 2e-3f;
+
+    emit("single", 1, timerNow() - t0, "jobs", checksum((const u32 *)&d, 16), err, ok);
+}
+
+/* Kernel BATCH at a few chunk sizes, SPU_RUNS jobs over the same array */
+static void benchBatch(vecmath_vec_t *v)
+{
+    static const u32 chunks[] = { 32, VECMATH_CHUNK_DEFAULT, VECMATH_CHUNK_MAX };
+    u32 runs = SPU_RUNS / iter_div, c, r;
+    char variant[32];
+
+    for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        float err;
+        u32 ea;
+        u64 t0;
+
+        spuReset();
+        fillVecs(v, SPU_VECTORS);
+        ea = spusim_map(v, SPU_VECTORS * sizeof(vecmath_vec_t));
+
+        t0 = timerNow();
+        for (r = 0; r < runs; r++)
+            spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_BATCH, chunks[c]) | VECMATH_JOB_STATUS,
+                          ea, SPU_VECTORS);
+        spusim_run_worker(ea_status);
+
+        err = vecmathRefMaxError(v, SPU_VECTORS);
+        snprintf(variant, sizeof(variant), "batch-%u", chunks[c]);
+        emit(variant, (u64)runs * SPU_VECTORS, timerNow() - t0, "vectors/s",
+             checksum((const u32 *)v, SPU_VECTORS * sizeof(vecmath_vec_t) / 4), err,
+             statusOk(runs, VECMATH_KERNEL_BATCH) && status.size == SPU_VECTORS && err < 2e-3f);
+    }
+}
+
+/* Kernel QUEUE: the shared-queue path, claimed one grain at a time */
+static void benchQueue(vecmath_vec_t *v)
+{
+    static vecmath_queue_t q __attribute__((aligned(128)));
+    u32 runs = SPU_RUNS / iter_div, r;
+    u32 ea_q, done = 0;
+    float err;
+    u64 t0, ticks = 0;
+
+    spuReset();
+    fillVecs(v, SPU_VECTORS);
+    ea_q = spusim_map(&q, sizeof(q));
+
+    memset(&q, 0, sizeof(q));
+    q.ea_vecs = spusim_map(v, SPU_VECTORS * sizeof(vecmath_vec_t));
+    q.count   = SPU_VECTORS;
+    q.grain   = 1024;
+    q.chunk   = VECMATH_CHUNK_DEFAULT;
+
+    /* The queue line is consumed by each job, so one job per worker run */
+    for (r = 0; r < runs; r++) {
+        q.next = 0;
+        t0 = timerNow();
+        spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_QUEUE, 0) | VECMATH_JOB_STATUS, ea_q, 0);
+        spusim_run_worker(ea_status);
+        ticks += timerNow() - t0;
+        done  += statusOk(1, VECMATH_KERNEL_QUEUE) ? status.size : 0;
+    }
+
+    err = vecmathRefMaxError(v, SPU_VECTORS);
+    emit("queue", (u64)runs * SPU_VECTORS, ticks, "vectors/s",
+         checksum((const u32 *)v, SPU_VECTORS * sizeof(vecmath_vec_t) / 4), err,
+         done == runs * SPU_VECTORS && q.next == SPU_VECTORS && err < 2e-3f);
+}
+
+/*
+ * Kernel SOA (overlay) per op and precision tier, the same table as
+ * bench.c's benchPrecision(). 'limit' is the largest relative error
+ * accepted: the tiers are ~12 bits, ~22 bits and 1-2 ulp.
+ */
+static void benchSoa(void)
+{
+    static const struct {
+        const char *name;
+        u32 op, flags, tiered;
+    } ops[] = {
+        { "magnitude", VECMATH_OP_VECMATH,   VECMATH_SOA_OUT_MAG,  1 },
+        { "normalize", VECMATH_OP_NORMALIZE, VECMATH_SOA_OUT_XYZW, 1 },
+        { "dot",       VECMATH_OP_DOT,       VECMATH_SOA_OUT_DOT,  0 },
+        { "cross",     VECMATH_OP_CROSS,     VECMATH_SOA_OUT_XYZW, 0 },
+        { "transform", VECMATH_OP_TRANSFORM, VECMATH_SOA_OUT_XYZW, 0 },
+    };
+    static const char *tiers[] = { "estimate", "newton", "full" };
+    static const float limit[] = { 2e-3f, 1e-5f, 1e-6f };
+    u32 runs = SPU_RUNS / iter_div, o, p, r, i;
+    vecmath_soa_t *soa;
+    char variant[32];
+
+    soa = vecmathSoaAlloc(SPU_VECTORS, 0);
+    if (!soa) {
+        fprintf(stderr, "spubench: out of memory\n");
+        failures++;
+        return;
+    }
+    for (i = 0; i < SPU_VECTORS; i++) {
+        vecmathSoaPlane(soa, VECMATH_SOA_X)[i] = 1.0f + (float)(i % 97);
+        vecmathSoaPlane(soa, VECMATH_SOA_Y)[i] = 0.5f * (float)(i % 13);
+        vecmathSoaPlane(soa, VECMATH_SOA_Z)[i] = -2.0f + (float)(i % 7);
+        vecmathSoaPlane(soa, VECMATH_SOA_W)[i] = 0.25f * (float)(i % 31);
+    }
+    for (i = 0; i < 16; i++)
+        soa->operand[i] = (i % 5 == 0) ? 1.0f : 0.125f * (float)i;
+
+    for (o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+        for (p = 0; p < (ops[o].tiered ? VECMATH_PREC_LEVELS : 1); p++) {
+            float err, max = ops[o].tiered ? limit[p] : limit[VECMATH_PREC_FULL];
+            u32 ea;
+            u64 t0, ticks = 0;
+            int ok = 1;
+
+            spuReset();
+            ea = spusim_map(soa, sizeof(*soa) + VECMATH_SOA_PLANES * soa->stride * sizeof(float));
+            soa->op    = ops[o].op;
+            soa->flags = ops[o].flags;
+            soa->prec  = p;
+            soa->grain = SPU_VECTORS;
+
+            /* Like the queue, the header's next field is used up by each job */
+            for (r = 0; r < runs; r++) {
+                soa->next = 0;
+                t0 = timerNow();
+                spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_SOA, 0) | VECMATH_JOB_STATUS, ea, 0);
+                spusim_run_worker(ea_status);
+                ticks += timerNow() - t0;
+                ok = ok && statusOk(1, VECMATH_KERNEL_SOA) && status.size == SPU_VECTORS;
+            }
+
+            err = vecmathRefSoaMaxError(soa);
+            snprintf(variant, sizeof(variant), "soa-%s-%s", ops[o].name,
+                     ops[o].tiered ? tiers[p] : "exact");
+            emit(variant, (u64)runs * SPU_VECTORS, ticks, "vectors/s",
+                 checksum((const u32 *)(soa + 1), VECMATH_SOA_PLANES * soa->stride), err,
+                 ok && err <= max);
+        }
+    }
+    vecmathSoaFree(soa);
+}
+
+/* Element i gets fillVecs()'s values; every other record byte is 0xa5 */
+static void fillRecords(u8 *records, u32 stride, u32 offset, const u32 *index)
+{
+    memset(records, 0xa5, SPU_VECTORS * stride);
+    benchDataFill(records, SPU_VECTORS, stride, offset, index);
+}
+
+/* Record bytes outside the embedded vector that are no longer 0xa5 */
+static u32 clobbered(const u8 *records, u32 stride, u32 offset)
+{
+    u32 i, n = 0;
+
+    for (i = 0; i < SPU_VECTORS * stride; i++) {
+        u32 in = i % stride;
+
+        if ((in < offset || in >= offset + sizeof(vecmath_vec_t)) && records[i] != 0xa5)
+            n++;
+    }
+    return n;
+}
+
+/*
+ * Kernel GATHER per record stride and through a shuffled index, and the
+ * staging copies + BATCH job it replaces. Besides the results, checks
+ * that the scatter left the rest of every record alone.
+ */
+static void benchGather(vecmath_vec_t *staging)
+{
+    static vecmath_gather_t g __attribute__((aligned(128)));
+    u32 runs = SPU_RUNS / iter_div, p, r;
+    char variant[32];
+    u32 *index;
+    u8 *records;
+
+    records = (u8 *)memalign(128, SPU_VECTORS * BENCH_DATA_STRIDE_MAX);
+    index   = (u32 *)memalign(128, VECMATH_GATHER_INDEX_LEN(SPU_VECTORS) * sizeof(u32));
+    if (!records || !index) {
+        fprintf(stderr, "spubench: out of memory\n");
+        failures++;
+        goto out;
+    }
+
+    benchDataShuffle(index, SPU_VECTORS, 12345);
+
+    for (p = 0; p < BENCH_DATA_LAYOUTS; p++) {
+        u32 stride, offset;
+        const u32 *idx = benchDataLayout(p, index, &stride, &offset);
+        u32 ea_vecs, ea_g, done = 0, bad;
+        float err;
+        u64 t0, ticks = 0;
+
+        /* Baseline: copy out, BATCH over the staging array, copy back */
+        spuReset();
+        fillRecords(records, stride, offset, idx);
+        ea_vecs = spusim_map(staging, SPU_VECTORS * sizeof(vecmath_vec_t));
+        for (r = 0; r < runs; r++) {
+            t0 = timerNow();
+            vecmathGatherStage(staging, records, SPU_VECTORS, stride, offset, idx);
+            spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_BATCH, 0) | VECMATH_JOB_STATUS,
+                          ea_vecs, SPU_VECTORS);
+            spusim_run_worker(ea_status);
+            vecmathGatherUnstage(staging, records, SPU_VECTORS, stride, offset, idx);
+            ticks += timerNow() - t0;
+        }
+        err = vecmathRefMaxError(staging, SPU_VECTORS);
+        snprintf(variant, sizeof(variant), "staged-%s-%u", idx ? "indexed" : "strided", stride);
+        emit(variant, (u64)runs * SPU_VECTORS, ticks, "vectors/s",
+             checksum((const u32 *)records, SPU_VECTORS * stride / 4), err,
+             statusOk(1, VECMATH_KERNEL_BATCH) && err < 2e-3f);
+
+        spuReset();
+        fillRecords(records, stride, offset, idx);
+        if (vecmathGatherSetup(&g, records, SPU_VECTORS, stride, offset, idx, 0) != 0) {
+            emit(variant, 0, 0, "vectors/s", 0, 0.0, 0);
+            continue;
+        }
+        g.ea_base  = spusim_map(records, SPU_VECTORS * stride);
+        g.ea_index = idx ? spusim_map(index, VECMATH_GATHER_INDEX_LEN(SPU_VECTORS) * sizeof(u32)) : 0;
+        ea_g  = spusim_map(&g, sizeof(g));
+        ticks = 0;
+        for (r = 0; r < runs; r++) {
+            g.next = 0;
+            t0 = timerNow();
+            spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_GATHER, 0) | VECMATH_JOB_STATUS,
+                          ea_g, 0);
+            spusim_run_worker(ea_status);
+            ticks += timerNow() - t0;
+            done  += statusOk(1, VECMATH_KERNEL_GATHER) ? status.size : 0;
+        }
+
+        vecmathGatherStage(staging, records, SPU_VECTORS, stride, offset, idx);
+        err = vecmathRefMaxError(staging, SPU_VECTORS);
+        bad = clobbered(records, stride, offset);
+        snprintf(variant, sizeof(variant), "gather-%s-%u", idx ? "indexed" : "strided", stride);
+        emit(variant, (u64)runs * SPU_VECTORS, ticks, "vectors/s",
+             checksum((const u32 *)records, SPU_VECTORS * stride / 4), err,
+             done == runs * SPU_VECTORS && bad == 0 && err < 2e-3f);
+        if (bad)
+            fprintf(stderr, "spubench: %s: %u record bytes clobbered\n", variant, bad);
+    }
+
+out:
+    free(records);
+    free(index);
+}
+
+/*
+ * A text frame as a display list: a background fill, a few boxes and
+ * glyph strings at every atlas scale, some crossing tile and screen edges.
+ * The same commands go to the software renderer for the reference.
+ */
+static u32 buildFrame(spudraw_cmd_t *cmds, u32 frame)
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789";
+    u32 n = 0, line, i;
+
+    cmds[n].kind = SPUDRAW_CMD_FILL;
+    cmds[n].x = 0;
+    cmds[n].y = 0;
+    cmds[n].w = SPU_FB_W;
+    cmds[n].h = SPU_FB_H;
+    cmds[n++].color = 0xff101020;
+
+    for (i = 0; i < 8; i++) {
+        cmds[n].kind = SPUDRAW_CMD_FILL;
+        cmds[n].x = (u16)((i * 173 + frame * 7) % SPU_FB_W);
+        cmds[n].y = (u16)((i * 97 + frame * 3) % SPU_FB_H);
+        cmds[n].w = (u16)(30 + i * 41);
+        cmds[n].h = (u16)(5 + i * 13);
+        cmds[n++].color = 0xff000000 | (i * 0x1f3d5b);
+    }
+
+    for (line = 0; line < 12; line++) {
+        u32 scale = 1 + line % GLYPH_MAX_SCALE;
+        u32 x = (line * 37 + frame * 5) % 200;
+        u32 y = 20 + line * 56;
+
+        for (i = 0; text[i] && x < SPU_FB_W; i++, x += FONT_W * scale) {
+            if (text[i] == ' ')
+                continue;
+            cmds[n].kind  = SPUDRAW_CMD_GLYPH;
+            cmds[n].x     = (u16)x;
+            cmds[n].y     = (u16)y;
+            cmds[n].ch    = (u8)text[i];
+            cmds[n].scale = (u8)scale;
+            cmds[n++].color = 0xffffffff - line * 0x00111111;
+        }
+    }
+    return n;
+}
+
+static void renderReference(const glyphTarget *t, const spudraw_cmd_t *cmds, u32 n)
+{
+    u32 i;
+
+    for (i = 0; i < n; i++) {
+        const spudraw_cmd_t *c = &cmds[i];
+
+        if (c->kind == SPUDRAW_CMD_GLYPH) {
+            glyphDrawChar(t, (char)c->ch, c->x, c->y, c->color, c->scale);
+        } else {
+            u32 w = c->x + c->w > t->width  ? t->width  - c->x : c->w;
+            u32 h = c->y + c->h > t->height ? t->height - c->y : c->h;
+
+            fillRows(t->ptr + c->y * (t->pitch / 4) + c->x, t->pitch, w, h, c->color, 0);
+        }
+    }
+}
+
+/*
+ * Kernel TILES (overlay) against the software renderer, pixel for pixel,
+ * claiming 'grain' tiles at a time
+ */
+static void benchTiles(const char *variant, u32 grain)
+{
+    static spudraw_frame_t frame __attribute__((aligned(128)));
+    u32 frames = SPU_FRAMES / iter_div, f, i, drawn = 0, diff = 0;
+    u32 words = SPU_FB_W * SPU_FB_H;
+    spudraw_cmd_t *cmds;
+    u32 *ticks;
+    glyphTarget spu, ref;
+    u64 t0, elapsed = 0;
+
+    cmds    = (spudraw_cmd_t *)memalign(128, SPUDRAW_MAX_CMDS * sizeof(spudraw_cmd_t));
+    ticks   = (u32 *)memalign(128, SPUDRAW_MAX_TILES * sizeof(u32));
+    spu.ptr = (u32 *)memalign(128, words * 4);
+    ref.ptr = (u32 *)memalign(128, words * 4);
+    if (!cmds || !ticks || !spu.ptr || !ref.ptr) {
+        fprintf(stderr, "spubench: out of memory\n");
+        failures++;
+        goto out;
+    }
+    memset(cmds, 0, SPUDRAW_MAX_CMDS * sizeof(spudraw_cmd_t));
+    spu.width  = ref.width  = SPU_FB_W;
+    spu.height = ref.height = SPU_FB_H;
+    spu.pitch  = ref.pitch  = SPU_FB_W * 4;
+    spu.offset = ref.offset = 0;
+
+    for (f = 0; f < frames; f++) {
+        spuReset();
+        memset(&frame, 0, sizeof(frame));
+        frame.cmd_count  = buildFrame(cmds, f);
+        frame.tiles_x    = (SPU_FB_W + SPUDRAW_TILE_W - 1) / SPUDRAW_TILE_W;
+        frame.tile_count = frame.tiles_x * ((SPU_FB_H + SPUDRAW_TILE_H - 1) / SPUDRAW_TILE_H);
+        frame.grain      = grain;
+        frame.fb_ea      = spusim_map(spu.ptr, words * 4);
+        frame.pitch      = spu.pitch;
+        frame.width      = SPU_FB_W;
+        frame.height     = SPU_FB_H;
+        frame.cmds_ea    = spusim_map(cmds, SPUDRAW_MAX_CMDS * sizeof(spudraw_cmd_t));
+        frame.ticks_ea   = spusim_map(ticks, SPUDRAW_MAX_TILES * sizeof(u32));
+
+        t0 = timerNow();
+        spusim_submit(VECMATH_JOB_CMD(VECMATH_KERNEL_TILES, 0) | VECMATH_JOB_STATUS,
+                      spusim_map(&frame, sizeof(frame)), 0);
+        spusim_run_worker(ea_status);
+        elapsed += timerNow() - t0;
+        drawn   += status.size;
+
+        renderReference(&ref, cmds, frame.cmd_count);
+        for (i = 0; i < words; i++)
+            diff += spu.ptr[i] != ref.ptr[i];
+    }
+
+    emit(variant, frames, elapsed, "frames/s", checksum(spu.ptr, words), (double)diff,
+         diff == 0 && statusOk(1, VECMATH_KERNEL_TILES) && drawn == frames * frame.tile_count);
+    if (diff)
+        fprintf(stderr, "spubench: %s: %u pixels differ from the software renderer\n",
+                variant, diff);
+
+out:
+    free(cmds);
+    free(ticks);
+    free(spu.ptr);
+    free(ref.ptr);
+}
+
+int main(int argc, char *argv[])
+{
+    vecmath_vec_t *v;
+
+    if (argc > 1 && strcmp(argv[1], "-q") == 0)
+        iter_div = 10;
+
+    v = (vecmath_vec_t *)memalign(128, SPU_VECTORS * sizeof(vecmath_vec_t));
+    if (!v) {
+        fprintf(stderr, "spubench: out of memory\n");
+        return 1;
+    }
+
+    benchSingle();
+    benchBatch(v);
+    benchQueue(v);
+    benchSoa();
+    benchGather(v);
+    benchTiles("tiles", 1);
+    benchTiles("tiles-grain4", 4);
+    free(v);
+
+    if (failures)
+        fprintf(stderr, "spubench: %u check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
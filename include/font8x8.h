@@ -0,0 +1,113 @@
+#ifndef __FONT8X8_H__
+#define __FONT8X8_H__
+
+/* ================================================================
+ *  Minimal 8x8 bitmap font (ASCII 32..126)
+ *  Each character is 8 rows, each row is a byte (MSB = left pixel).
+ *  Shared by the PPU text renderers (and small enough for SPU local store).
+ * ================================================================ */
+
+#define FONT_W          8
+#define FONT_H          8
+#define FONT_FIRST      32
+#define FONT_LAST       126
+
+static const unsigned char font8x8[95][8] = {
+    /* 32 ' ' */ {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+    /* 33 '!' */ {0x18,0x18,0x18,0x18,0x18,0x00,0x18,0x00},
+    /* 34 '"' */ {0x6C,0x6C,0x24,0x00,0x00,0x00,0x00,0x00},
+    /* 35 '#' */ {0x24,0x7E,0x24,0x24,0x7E,0x24,0x00,0x00},
+    /* 36 '$' */ {0x18,0x3E,0x58,0x3C,0x1A,0x7C,0x18,0x00},
+    /* 37 '%' */ {0x62,0x64,0x08,0x10,0x26,0x46,0x00,0x00},
+    /* 38 '&' */ {0x30,0x48,0x30,0x56,0x88,0x76,0x00,0x00},
+    /* 39 ''' */ {0x18,0x18,0x10,0x00,0x00,0x00,0x00,0x00},
+    /* 40 '(' */ {0x08,0x10,0x20,0x20,0x20,0x10,0x08,0x00},
+    /* 41 ')' */ {0x20,0x10,0x08,0x08,0x08,0x10,0x20,0x00},
+    /* 42 '*' */ {0x00,0x24,0x18,0x7E,0x18,0x24,0x00,0x00},
+    /* 43 '+' */ {0x00,0x18,0x18,0x7E,0x18,0x18,0x00,0x00},
+    /* 44 ',' */ {0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x10},
+    /* 45 '-' */ {0x00,0x00,0x00,0x7E,0x00,0x00,0x00,0x00},
+    /* 46 '.' */ {0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x00},
+    /* 47 '/' */ {0x02,0x04,0x08,0x10,0x20,0x40,0x00,0x00},
+    /* 48 '0' */ {0x3C,0x46,0x4A,0x52,0x62,0x3C,0x00,0x00},
+    /* 49 '1' */ {0x18,0x38,0x18,0x18,0x18,0x7E,0x00,0x00},
+    /* 50 '2' */ {0x3C,0x42,0x04,0x18,0x20,0x7E,0x00,0x00},
+    /* 51 '3' */ {0x3C,0x42,0x0C,0x02,0x42,0x3C,0x00,0x00},
+    /* 52 '4' */ {0x08,0x18,0x28,0x48,0x7E,0x08,0x00,0x00},
+    /* 53 '5' */ {0x7E,0x40,0x7C,0x02,0x42,0x3C,0x00,0x00},
+    /* 54 '6' */ {0x1C,0x20,0x7C,0x42,0x42,0x3C,0x00,0x00},
+    /* 55 '7' */ {0x7E,0x02,0x04,0x08,0x10,0x10,0x00,0x00},
+    /* 56 '8' */ {0x3C,0x42,0x3C,0x42,0x42,0x3C,0x00,0x00},
+    /* 57 '9' */ {0x3C,0x42,0x42,0x3E,0x04,0x38,0x00,0x00},
+    /* 58 ':' */ {0x00,0x18,0x18,0x00,0x18,0x18,0x00,0x00},
+    /* 59 ';' */ {0x00,0x18,0x18,0x00,0x18,0x18,0x10,0x00},
+    /* 60 '<' */ {0x04,0x08,0x10,0x20,0x10,0x08,0x04,0x00},
+    /* 61 '=' */ {0x00,0x00,0x7E,0x00,0x7E,0x00,0x00,0x00},
+    /* 62 '>' */ {0x20,0x10,0x08,0x04,0x08,0x10,0x20,0x00},
+    /* 63 '?' */ {0x3C,0x42,0x04,0x08,0x08,0x00,0x08,0x00},
+    /* 64 '@' */ {0x3C,0x42,0x5E,0x52,0x5E,0x40,0x3C,0x00},
+    /* 65 'A' */ {0x18,0x24,0x42,0x7E,0x42,0x42,0x00,0x00},
+    /* 66 'B' */ {0x7C,0x42,0x7C,0x42,0x42,0x7C,0x00,0x00},
+    /* 67 'C' */ {0x3C,0x42,0x40,0x40,0x42,0x3C,0x00,0x00},
+    /* 68 'D' */ {0x78,0x44,0x42,0x42,0x44,0x78,0x00,0x00},
+    /* 69 'E' */ {0x7E,0x40,0x7C,0x40,0x40,0x7E,0x00,0x00},
+    /* 70 'F' */ {0x7E,0x40,0x7C,0x40,0x40,0x40,0x00,0x00},
+    /* 71 'G' */ {0x3C,0x42,0x40,0x4E,0x42,0x3C,0x00,0x00},
+    /* 72 'H' */ {0x42,0x42,0x7E,0x42,0x42,0x42,0x00,0x00},
+    /* 73 'I' */ {0x7E,0x18,0x18,0x18,0x18,0x7E,0x00,0x00},
+    /* 74 'J' */ {0x1E,0x04,0x04,0x04,0x44,0x38,0x00,0x00},
+    /* 75 'K' */ {0x44,0x48,0x70,0x48,0x44,0x42,0x00,0x00},
+    /* 76 'L' */ {0x40,0x40,0x40,0x40,0x40,0x7E,0x00,0x00},
+    /* 77 'M' */ {0x42,0x66,0x5A,0x42,0x42,0x42,0x00,0x00},
+    /* 78 'N' */ {0x42,0x62,0x52,0x4A,0x46,0x42,0x00,0x00},
+    /* 79 'O' */ {0x3C,0x42,0x42,0x42,0x42,0x3C,0x00,0x00},
+    /* 80 'P' */ {0x7C,0x42,0x42,0x7C,0x40,0x40,0x00,0x00},
+    /* 81 'Q' */ {0x3C,0x42,0x42,0x4A,0x44,0x3A,0x00,0x00},
+    /* 82 'R' */ {0x7C,0x42,0x42,0x7C,0x44,0x42,0x00,0x00},
+    /* 83 'S' */ {0x3C,0x40,0x3C,0x02,0x42,0x3C,0x00,0x00},
+    /* 84 'T' */ {0x7E,0x18,0x18,0x18,0x18,0x18,0x00,0x00},
+    /* 85 'U' */ {0x42,0x42,0x42,0x42,0x42,0x3C,0x00,0x00},
+    /* 86 'V' */ {0x42,0x42,0x42,0x24,0x24,0x18,0x00,0x00},
+    /* 87 'W' */ {0x42,0x42,0x42,0x5A,0x66,0x42,0x00,0x00},
+    /* 88 'X' */ {0x42,0x24,0x18,0x18,0x24,0x42,0x00,0x00},
+    /* 89 'Y' */ {0x42,0x42,0x24,0x18,0x18,0x18,0x00,0x00},
+    /* 90 'Z' */ {0x7E,0x04,0x08,0x10,0x20,0x7E,0x00,0x00},
+    /* 91 '[' */ {0x3C,0x20,0x20,0x20,0x20,0x3C,0x00,0x00},
+    /* 92 '\' */ {0x40,0x20,0x10,0x08,0x04,0x02,0x00,0x00},
+    /* 93 ']' */ {0x3C,0x04,0x04,0x04,0x04,0x3C,0x00,0x00},
+    /* 94 '^' */ {0x10,0x28,0x44,0x00,0x00,0x00,0x00,0x00},
+    /* 95 '_' */ {0x00,0x00,0x00,0x00,0x00,0x00,0x7E,0x00},
+    /* 96 '`' */ {0x18,0x18,0x08,0x00,0x00,0x00,0x00,0x00},
+    /* 97 'a' */ {0x00,0x00,0x3C,0x02,0x3E,0x42,0x3E,0x00},
+    /* 98 'b' */ {0x40,0x40,0x7C,0x42,0x42,0x42,0x7C,0x00},
+    /* 99 'c' */ {0x00,0x00,0x3C,0x40,0x40,0x40,0x3C,0x00},
+    /*100 'd' */ {0x02,0x02,0x3E,0x42,0x42,0x42,0x3E,0x00},
+    /*101 'e' */ {0x00,0x00,0x3C,0x42,0x7E,0x40,0x3C,0x00},
+    /*102 'f' */ {0x0C,0x10,0x3C,0x10,0x10,0x10,0x10,0x00},
+    /*103 'g' */ {0x00,0x00,0x3E,0x42,0x42,0x3E,0x02,0x3C},
+    /*104 'h' */ {0x40,0x40,0x7C,0x42,0x42,0x42,0x42,0x00},
+    /*105 'i' */ {0x18,0x00,0x38,0x18,0x18,0x18,0x3C,0x00},
+    /*106 'j' */ {0x04,0x00,0x04,0x04,0x04,0x04,0x44,0x38},
+    /*107 'k' */ {0x40,0x40,0x44,0x48,0x70,0x48,0x44,0x00},
+    /*108 'l' */ {0x38,0x18,0x18,0x18,0x18,0x18,0x3C,0x00},
+    /*109 'm' */ {0x00,0x00,0x66,0x5A,0x5A,0x42,0x42,0x00},
+    /*110 'n' */ {0x00,0x00,0x7C,0x42,0x42,0x42,0x42,0x00},
+    /*111 'o' */ {0x00,0x00,0x3C,0x42,0x42,0x42,0x3C,0x00},
+    /*112 'p' */ {0x00,0x00,0x7C,0x42,0x42,0x7C,0x40,0x40},
+    /*113 'q' */ {0x00,0x00,0x3E,0x42,0x42,0x3E,0x02,0x02},
+    /*114 'r' */ {0x00,0x00,0x5C,0x62,0x40,0x40,0x40,0x00},
+    /*115 's' */ {0x00,0x00,0x3E,0x40,0x3C,0x02,0x7C,0x00},
+    /*116 't' */ {0x10,0x10,0x7C,0x10,0x10,0x10,0x0C,0x00},
+    /*117 'u' */ {0x00,0x00,0x42,0x42,0x42,0x42,0x3E,0x00},
+    /*118 'v' */ {0x00,0x00,0x42,0x42,0x24,0x24,0x18,0x00},
+    /*119 'w' */ {0x00,0x00,0x42,0x42,0x5A,0x5A,0x66,0x00},
+    /*120 'x' */ {0x00,0x00,0x42,0x24,0x18,0x24,0x42,0x00},
+    /*121 'y' */ {0x00,0x00,0x42,0x42,0x42,0x3E,0x02,0x3C},
+    /*122 'z' */ {0x00,0x00,0x7E,0x04,0x18,0x20,0x7E,0x00},
+    /*123 '{' */ {0x0C,0x10,0x10,0x20,0x10,0x10,0x0C,0x00},
+    /*124 '|' */ {0x18,0x18,0x18,0x00,0x18,0x18,0x18,0x00},
+    /*125 '}' */ {0x30,0x08,0x08,0x04,0x08,0x08,0x30,0x00},
+    /*126 '~' */ {0x00,0x32,0x4C,0x00,0x00,0x00,0x00,0x00},
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __SPUDRAW_H__
+#define __SPUDRAW_H__
+
+/*
+ * Rasterizado de texto por tiles en los SPEs (kernel VECMATH_KERNEL_TILES).
+ *
+ * El PPU arma por frame una display list compacta de comandos de 16 bytes
+ * (rellenos de rectangulo y glyphs ya posicionados). Los SPUs reclaman
+ * tiles del framebuffer con getllar/putllc, traen el tile a Local Store,
+ * aplican en orden los comandos que lo tocan usando stores de 128 bits
+ * con la fuente 8x8 residente en LS, y lo devuelven por DMA directo al
+ * framebuffer del RSX.
+ */
+
+#define SPUDRAW_TILE_W      128     /* pixeles: 512 bytes por fila de tile */
+#define SPUDRAW_TILE_H      16
+#define SPUDRAW_MAX_CMDS    2048    /* 32 KB de display list en LS */
+#define SPUDRAW_MAX_TILES   2048    /* 1080p usa 15 x 68 = 1020 */
+
+#define SPUDRAW_CMD_FILL    1       /* rectangulo x, y, w, h de color solido */
+#define SPUDRAW_CMD_GLYPH   2       /* caracter 'ch' en x, y con 'scale' */
+
+typedef struct _spudraw_cmd {
+    unsigned short x, y;
+    unsigned short w, h;            /* solo FILL */
+    unsigned char  kind;
+    unsigned char  ch;
+    unsigned char  scale;
+    unsigned char  pad;
+    unsigned int   color;
+} spudraw_cmd_t __attribute__((aligned(16)));
+
+/*
+ * Descriptor del frame: una linea de reserva de 128 bytes. Las tres
+ * primeras palabras tienen el mismo formato que vecmath_queue_t
+ * (next/count/grain) para reusar el reclamo atomico del SPU.
+ */
+typedef struct _spudraw_frame {
+    unsigned int next_tile;         /* primer tile sin reclamar */
+    unsigned int tile_count;
+    unsigned int grain;             /* tiles por reclamo, todos dibujados */
+    unsigned int tiles_x;
+    unsigned int fb_ea;             /* framebuffer destino (memoria RSX mapeada) */
+    unsigned int pitch;             /* bytes */
+    unsigned int width;
+    unsigned int height;
+    unsigned int cmds_ea;           /* spudraw_cmd_t[cmd_count], alineado a 128 */
+    unsigned int cmd_count;
+    unsigned int ticks_ea;          /* unsigned int por tile: ticks del decrementer, 0 = tile sin comandos */
+    unsigned int pad[21];
+} spudraw_frame_t __attribute__((aligned(128)));
+
+#endif
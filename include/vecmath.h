@@ -19,4 +19,218 @@ typedef struct _vecmath_data {
     unsigned int pad[21]; /* pad to exactly 128 bytes (DMA requires multiples of 16) */
 } vecmath_data_t __attribute__((aligned(128)));
 
+/*
+ * Elemento del modo batch: mismo calculo que vecmath_data_t pero sin el
+ * relleno a 128 bytes, para poder transferir arrays contiguos de miles de
+ * vectores. 48 bytes por elemento (multiplo de 16, requisito del DMA).
+ *
+ * El array debe empezar en una direccion alineada a 128 bytes para que
+ * cada chunk del SPU arranque en una linea de cache completa.
+ */
+typedef struct _vecmath_vec {
+    float input[4];
+    float output[4];
+    float dot_product;
+    float magnitude;
+    unsigned int pad[2];
+} vecmath_vec_t __attribute__((aligned(16)));
+
+/*
+ * Tamano de chunk (en vectores) que el SPU trae a Local Store por cada DMA.
+ * Una transferencia DMA no puede superar 16 KB: 256 * 48 = 12 KB.
+ */
+#define VECMATH_CHUNK_MAX       256
+#define VECMATH_CHUNK_DEFAULT   128
+
+/*
+ * Modo del thread SPU (arg3):
+ *   ONESHOT: procesa arg0/arg1/arg2 una vez y termina (spu_thread_exit)
+ *   WORKER:  queda residente leyendo jobs del inbound mailbox
+ */
+#define VECMATH_MODE_ONESHOT    0
+#define VECMATH_MODE_WORKER     1
+
+/*
+ * Protocolo del worker: cada job son 3 palabras en el inbound mailbox
+ *   1. comando: kernel id (bits 0-7) | chunk del modo batch (bits 16-31)
+ *   2. EA de los datos (32 bits, el espacio de usuario de lv2 es de 32 bits)
+ *   3. tamano en vectores
+ * Al terminar, el SPU envia un evento por el outbound interrupt mailbox
+ * (sys_spu_thread_throw_event) al puerto VECMATH_EVENT_PORT con
+ * data0 = kernel id y data1 = tamano procesado.
+ */
+#define VECMATH_KERNEL_QUIT     0   /* sale del loop y termina el thread */
+#define VECMATH_KERNEL_SINGLE   1   /* EA -> vecmath_data_t */
+#define VECMATH_KERNEL_BATCH    2   /* EA -> vecmath_vec_t[size] */
+#define VECMATH_KERNEL_QUEUE    3   /* EA -> vecmath_queue_t, size ignorado */
+#define VECMATH_KERNEL_TILES    4   /* EA -> spudraw_frame_t (ver spudraw.h) */
+#define VECMATH_KERNEL_SOA      5   /* EA -> vecmath_soa_t, size ignorado */
+#define VECMATH_KERNEL_GATHER   6   /* EA -> vecmath_gather_t, size ignorado */
+#define VECMATH_KERNEL_COUNT    7
+
+#define VECMATH_JOB_CMD(kernel, chunk)  ((unsigned int)(kernel) | ((unsigned int)(chunk) << 16))
+#define VECMATH_JOB_KERNEL(cmd)         ((cmd) & 0xff)
+#define VECMATH_JOB_CHUNK(cmd)          ((cmd) >> 16)
+
+/*
+ * Flag del comando (bit 8): en vez del evento, el fin del job se avisa
+ * escribiendo el quadword de estado del worker (vecmath_status_t). El PPU
+ * lo lee de su cache sin syscalls; el evento pasa por lv2 y despierta un
+ * thread bloqueado en la event queue.
+ */
+#define VECMATH_JOB_STATUS      0x100
+
+#define VECMATH_EVENT_PORT      1
+
+/*
+ * Overlays: los kernels grandes o poco usados (TILES, SOA) no viven en la
+ * imagen residente sino en binarios aparte que el SPU trae por DMA a una
+ * region reservada de LS la primera vez que un job los pide. En modo worker
+ * arg2 es la EA de una tabla de VECMATH_OVERLAYS entradas con la EA y el
+ * tamano de cada binario (0 = no disponible; el kernel devuelve 0).
+ */
+#define VECMATH_OVERLAY_TILES   0
+#define VECMATH_OVERLAY_SOA     1
+#define VECMATH_OVERLAYS        2
+
+typedef struct _vecmath_overlay {
+    unsigned int ea;        /* binario alineado a 128 */
+    unsigned int size;      /* bytes */
+    unsigned int pad[2];
+} vecmath_overlay_t __attribute__((aligned(16)));
+
+/*
+ * Estado de fin de job de un worker: un quadword, escrito con un solo DMA
+ * de 16 bytes (atomico por estar alineado). 'seq' cuenta los jobs que
+ * termino el thread; el PPU lleva la misma cuenta al enviarlos, asi que el
+ * job n termino cuando seq == n. En modo worker el SPU recibe en arg0 la
+ * EA del array de estados y en arg1 su indice.
+ */
+typedef struct _vecmath_status {
+    unsigned int seq;       /* jobs terminados por este thread */
+    unsigned int kernel;    /* kernel del ultimo job */
+    unsigned int size;      /* tamano procesado, como data1 del evento */
+    unsigned int pad;
+} vecmath_status_t __attribute__((aligned(16)));
+
+/*
+ * Cola de trabajo compartida por varios SPEs (kernel QUEUE).
+ * Ocupa exactamente una linea de reserva de 128 bytes: cada SPU reclama
+ * 'grain' vectores a partir de 'next' con getllar/putllc, sin locks en el
+ * PPU. Un SPU termina su job cuando 'next' llega a 'count'.
+ */
+typedef struct _vecmath_queue {
+    unsigned int next;      /* primer vector sin reclamar */
+    unsigned int count;     /* total de vectores en el array */
+    unsigned int grain;     /* vectores por reclamo */
+    unsigned int chunk;     /* chunk DMA dentro de cada reclamo */
+    unsigned int ea_vecs;   /* EA del array vecmath_vec_t (alineado a 128) */
+    unsigned int pad[27];
+} vecmath_queue_t __attribute__((aligned(128)));
+
+/*
+ * Niveles de precision de rsqrt/sqrt/normalize en el SPU (ver
+ * spu/source/spumath.h). Se eligen por job en vecmath_soa_t.prec.
+ */
+#define VECMATH_PREC_ESTIMATE   0   /* spu_rsqrte solo, ~12 bits */
+#define VECMATH_PREC_NEWTON     1   /* + un paso de Newton-Raphson */
+#define VECMATH_PREC_FULL       2   /* 1-2 ulp */
+#define VECMATH_PREC_LEVELS     3
+
+/*
+ * Batch en formato SoA (kernel SOA). vecmath_vec_t mueve 96 bytes por
+ * vector (48 de ida y 48 de vuelta) para 16 de entrada; aca cada
+ * componente va en su propio plano de floats, asi el SPU procesa 4
+ * vectores por operacion SIMD sin shuffles y el DMA solo mueve datos.
+ *
+ * Memoria: la cabecera de 128 bytes y a continuacion VECMATH_SOA_PLANES
+ * planos de 'stride' floats cada uno (plano p en cabecera + 128 +
+ * p * stride * 4). 'stride' es multiplo de VECMATH_SOA_ALIGN para que cada
+ * plano empiece en una linea de 128 bytes.
+ *
+ * Los primeros tres campos son la linea de reserva next/count/grain, igual
+ * que vecmath_queue_t: varios SPEs pueden repartirse el mismo batch.
+ * 'flags' elige que planos de salida se devuelven.
+ */
+#define VECMATH_SOA_X           0   /* entrada */
+#define VECMATH_SOA_Y           1
+#define VECMATH_SOA_Z           2
+#define VECMATH_SOA_W           3
+#define VECMATH_SOA_OUT_X       4   /* salida vectorial (depende de 'op') */
+#define VECMATH_SOA_OUT_Y       5
+#define VECMATH_SOA_OUT_Z       6
+#define VECMATH_SOA_OUT_W       7
+#define VECMATH_SOA_DOT         8   /* salida: producto punto */
+#define VECMATH_SOA_MAG         9   /* salida: magnitud */
+#define VECMATH_SOA_PLANES      10
+
+#define VECMATH_SOA_OUT_XYZW    0x1 /* planos OUT_X..OUT_W */
+#define VECMATH_SOA_OUT_DOT     0x2
+#define VECMATH_SOA_OUT_MAG     0x4
+#define VECMATH_SOA_OUT_ALL     0x7
+
+/*
+ * Operacion del job ('op'); 'k' es operand[0..3] y 'M' operand[0..15]
+ * (4x4 por filas):
+ *   VECMATH: OUT = cuadrados, DOT = |v|^2, MAG = |v|
+ *   NORMALIZE: OUT = v / |v| (0 si v es nulo), DOT = |v|^2, MAG = |v|
+ *   DOT:     DOT = v . k
+ *   CROSS:   OUT_X..OUT_Z = v.xyz x k.xyz, OUT_W = 0
+ *   TRANSFORM: OUT = M * v
+ * 'prec' solo afecta a MAG y a NORMALIZE.
+ */
+#define VECMATH_OP_VECMATH      0
+#define VECMATH_OP_NORMALIZE    1
+#define VECMATH_OP_DOT          2
+#define VECMATH_OP_CROSS        3
+#define VECMATH_OP_TRANSFORM    4
+#define VECMATH_OP_COUNT        5
+
+#define VECMATH_SOA_ALIGN       32  /* floats por linea de 128 bytes */
+#define VECMATH_SOA_CHUNK       512 /* vectores por DMA (2 KB por plano) */
+
+typedef struct _vecmath_soa {
+    unsigned int next;      /* primer vector sin reclamar */
+    unsigned int count;     /* vectores en el batch */
+    unsigned int grain;     /* vectores por reclamo (multiplo de 4) */
+    unsigned int stride;    /* floats por plano (multiplo de VECMATH_SOA_ALIGN) */
+    unsigned int flags;     /* VECMATH_SOA_OUT_* */
+    unsigned int op;        /* VECMATH_OP_* */
+    unsigned int prec;      /* VECMATH_PREC_* */
+    unsigned int pad0;
+    float operand[16];      /* vector k o matriz M, segun 'op' */
+    unsigned int pad[8];
+} vecmath_soa_t __attribute__((aligned(128)));
+
+/*
+ * Gather/scatter con listas DMA (kernel GATHER). Los vectores no estan en
+ * un array propio sino embebidos en registros mas grandes (por ejemplo la
+ * posicion dentro del struct de una entidad): el elemento i es el
+ * vecmath_vec_t en
+ *
+ *   ea_base + r * stride + offset,  con r = i, o r = indice[i] si ea_index != 0
+ *
+ * El SPU arma una lista DMA por chunk (un elemento de 48 bytes por
+ * vector), la junta en LS con mfc_getl como un array contiguo, calcula y
+ * devuelve cada vector a su registro con mfc_putl sobre la misma lista. El
+ * PPU no copia nada a un array intermedio.
+ *
+ * 'stride', 'offset' y 'ea_base' deben ser multiplos de 16 (cada elemento
+ * de la lista es un DMA de 48 bytes). El array de indices (unsigned int,
+ * alineado a 16) se lee por quadwords completos: debe tener espacio hasta
+ * el siguiente multiplo de 4 entradas. Los primeros tres campos son la
+ * linea de reserva next/count/grain, igual que vecmath_queue_t.
+ */
+typedef struct _vecmath_gather {
+    unsigned int next;      /* primer elemento sin reclamar */
+    unsigned int count;     /* elementos */
+    unsigned int grain;     /* elementos por reclamo */
+    unsigned int chunk;     /* elementos por lista DMA (0 = VECMATH_CHUNK_DEFAULT) */
+    unsigned int ea_base;   /* EA del registro 0 */
+    unsigned int stride;    /* bytes entre registros */
+    unsigned int offset;    /* bytes del vecmath_vec_t dentro del registro */
+    unsigned int ea_index;  /* EA de los indices de registro (0 = r = i) */
+    unsigned int pad[24];
+} vecmath_gather_t __attribute__((aligned(128)));
+
 #endif
@@ -6,57 +6,433 @@
  *   - El producto punto (norma al cuadrado)
  *   - La magnitud aproximada (usando rsqrte del SPU)
  * Y devuelve los resultados al PPU via DMA.
+ *
+ * Argumentos del thread:
+ *   arg0 = EA de los datos
+ *   arg1 = cantidad de vectores (0 = modo simple, un vecmath_data_t)
+ *   arg2 = tamano de chunk del modo batch (0 = VECMATH_CHUNK_DEFAULT)
+ *   arg3 = VECMATH_MODE_ONESHOT o VECMATH_MODE_WORKER
+ *
+ * En modo worker el SPU queda residente y recibe jobs por el inbound
+ * mailbox (ver protocolo en vecmath.h), evitando crear un thread por calculo;
+ * arg0 es la EA del array de vecmath_status_t, arg1 el indice del thread y
+ * arg2 la tabla de overlays. Los kernels se buscan en una tabla por id.
+ * Con el kernel QUEUE varios SPEs reparten un mismo batch reclamando rangos
+ * de una cola en memoria principal con reservas atomicas (getllar/putllc).
+ * El kernel TILES (tiles.c) rasteriza texto por tiles del framebuffer y
+ * el kernel SOA (soa.c) procesa batches en planos x/y/z/w; los dos son
+ * overlays que se cargan en LS cuando llega un job suyo (overlay.c).
+ * El kernel GATHER junta con listas DMA vectores embebidos en registros
+ * mas grandes y los devuelve a su lugar.
  */
 #include <spu_intrinsics.h>
 #include <spu_mfcio.h>
 #include <sys/spu_thread.h>
 
 #include "vecmath.h"
-
-#define TAG 1
+#include "spumath.h"
+#include "spu_common.h"
 
 static vecmath_data_t data __attribute__((aligned(128)));
 
-static void wait_for_dma(void)
+/* Linea de reserva para la cola compartida (getllar/putllc trabajan con 128 bytes) */
+static vecmath_queue_t queue_line __attribute__((aligned(128)));
+
+/* Doble buffer del modo batch: mientras se calcula uno, el otro se transfiere */
+static vecmath_vec_t batch_buf[2][VECMATH_CHUNK_MAX] __attribute__((aligned(128)));
+
+/*
+ * Kernel GATHER: linea de reserva del descriptor y, por cada buffer de
+ * batch_buf, su lista DMA (la misma para el getl y el putl) y los indices
+ * del chunk (hasta 3 de mas al alinear el DMA a 16 bytes).
+ */
+static vecmath_gather_t gather_line __attribute__((aligned(128)));
+static mfc_list_element_t gather_list[2][VECMATH_CHUNK_MAX] __attribute__((aligned(8)));
+static unsigned int gather_index[2][VECMATH_CHUNK_MAX + 4] __attribute__((aligned(16)));
+
+void wait_for_tag(unsigned int tag)
 {
-    mfc_write_tag_mask(1 << TAG);
+    mfc_write_tag_mask(1 << tag);
     spu_mfcstat(MFC_TAG_UPDATE_ALL);
 }
 
-int main(uint64_t ea_data, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+static void wait_for_dma(void)
 {
-    (void)arg2; (void)arg3; (void)arg4;
-
-    /* 1. DMA get: traer struct desde memoria principal */
-    mfc_get(&data, ea_data, sizeof(vecmath_data_t), TAG, 0, 0);
-    wait_for_dma();
-
-    /* 2. Cargar input en registro SIMD de 128 bits */
-    vector float v_input = *(vector float *)data.input;
+    wait_for_tag(TAG);
+}
 
-    /* 3. Cuadrado de cada componente: output = input * input */
+/*
+ * Calculo de un vector: cuadrados, producto punto y magnitud.
+ * El producto punto y la magnitud quedan replicados en los 4 elementos.
+ */
+static inline vector float compute_vec(vector float v_input,
+                                       vector float *v_dot_out,
+                                       vector float *v_mag_out)
+{
+    /* Cuadrado de cada componente: output = input * input */
     vector float v_squared = spu_mul(v_input, v_input);
-    *(vector float *)data.output = v_squared;
 
-    /* 4. Producto punto: suma horizontal de los 4 elementos */
+    /* Producto punto: suma horizontal de los 4 elementos */
     vector float v_rot1 = (vector float)spu_rlqwbyte((vector unsigned char)v_squared, 4);
     vector float v_sum1 = spu_add(v_squared, v_rot1);
     vector float v_rot2 = (vector float)spu_rlqwbyte((vector unsigned char)v_sum1, 8);
     vector float v_dot  = spu_add(v_sum1, v_rot2);
 
-    data.dot_product = spu_extract(v_dot, 0);
+    /* Magnitud: sqrt(dot) = dot * rsqrte(dot), con sqrt(0) = 0 */
+    *v_dot_out = v_dot;
+    *v_mag_out = spumath_sqrt(v_dot, VECMATH_PREC_ESTIMATE);
+    return v_squared;
+}
+
+static void process_chunk(vecmath_vec_t *v, unsigned int n)
+{
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        vector float v_dot, v_mag;
+        vector float v_squared = compute_vec(*(vector float *)v[i].input,
+                                             &v_dot, &v_mag);
+
+        *(vector float *)v[i].output = v_squared;
+        v[i].dot_product = spu_extract(v_dot, 0);
+        v[i].magnitude   = spu_extract(v_mag, 0);
+    }
+}
+
+/*
+ * Modo batch: recorre 'count' vectores en chunks con doble buffer.
+ *
+ * En cada iteracion se pide el chunk siguiente (get con barrera, para que
+ * no pise el put pendiente del mismo buffer), se espera el chunk actual,
+ * se calcula y se devuelve con put. Asi el DMA de un buffer se solapa con
+ * el calculo del otro.
+ */
+static void run_batch(uint64_t ea, unsigned int count, unsigned int chunk)
+{
+    unsigned int cur  = 0;
+    unsigned int done = 0;
+    unsigned int n    = count < chunk ? count : chunk;
+
+    mfc_get(batch_buf[cur], ea, n * sizeof(vecmath_vec_t), TAG_BUF + cur, 0, 0);
+
+    while (done < count) {
+        unsigned int next = done + n;
+        unsigned int nn   = 0;
+
+        if (next < count) {
+            nn = count - next < chunk ? count - next : chunk;
+            mfc_getb(batch_buf[cur ^ 1], ea + (uint64_t)next * sizeof(vecmath_vec_t),
+                     nn * sizeof(vecmath_vec_t), TAG_BUF + (cur ^ 1), 0, 0);
+        }
 
-    /* 5. Magnitud: sqrt(dot) = dot * rsqrte(dot) */
-    vector float v_rsqrt = spu_rsqrte(v_dot);
-    vector float v_mag   = spu_mul(v_dot, v_rsqrt);
-    data.magnitude = spu_extract(v_mag, 0);
+        wait_for_tag(TAG_BUF + cur);
+        process_chunk(batch_buf[cur], n);
+        mfc_put(batch_buf[cur], ea + (uint64_t)done * sizeof(vecmath_vec_t),
+                n * sizeof(vecmath_vec_t), TAG_BUF + cur, 0, 0);
 
-    /* 6. Marcar como completado */
+        done = next;
+        n    = nn;
+        cur ^= 1;
+    }
+
+    mfc_write_tag_mask((1 << TAG_BUF) | (1 << (TAG_BUF + 1)));
+    spu_mfcstat(MFC_TAG_UPDATE_ALL);
+}
+
+static void run_single(uint64_t ea_data)
+{
+    vector float v_dot, v_mag;
+
+    /* 1. DMA get: traer struct desde memoria principal */
+    mfc_get(&data, ea_data, sizeof(vecmath_data_t), TAG, 0, 0);
+    wait_for_dma();
+
+    /* 2. Cargar input en registro SIMD de 128 bits y calcular */
+    vector float v_input = *(vector float *)data.input;
+    *(vector float *)data.output = compute_vec(v_input, &v_dot, &v_mag);
+
+    data.dot_product = spu_extract(v_dot, 0);
+    data.magnitude   = spu_extract(v_mag, 0);
+
+    /* 3. Marcar como completado */
     data.done = 1;
 
-    /* 7. DMA put: enviar resultados de vuelta al PPU */
+    /* 4. DMA put: enviar resultados de vuelta al PPU */
     mfc_put(&data, ea_data, sizeof(vecmath_data_t), TAG, 0, 0);
     wait_for_dma();
+}
+
+/*
+ * Reclama el siguiente rango de una linea next/count/grain. Si otro SPU
+ * modifica la linea entre getllar y putllc, la reserva se pierde y se
+ * reintenta.
+ */
+unsigned int claim_range(uint64_t ea, volatile unsigned int *line, unsigned int *start)
+{
+    unsigned int next, count, grain, take;
+
+    do {
+        mfc_getllar(line, ea, 0, 0);
+        mfc_read_atomic_status();
+
+        next  = line[0];
+        count = line[1];
+        grain = line[2];
+        if (next >= count)
+            return 0;
+
+        take = count - next;
+        if (take > grain)
+            take = grain;
+
+        *start  = next;
+        line[0] = next + take;
+
+        mfc_putllc(line, ea, 0, 0);
+    } while (mfc_read_atomic_status() & MFC_PUTLLC_STATUS);
+
+    return take;
+}
+
+static unsigned int clamp_chunk(unsigned int chunk)
+{
+    if (chunk == 0)
+        return VECMATH_CHUNK_DEFAULT;
+    if (chunk > VECMATH_CHUNK_MAX)
+        return VECMATH_CHUNK_MAX;
+    return chunk;
+}
+
+/*
+ * sys_spu_thread_throw_event: data1 va al outbound mailbox y el puerto +
+ * data0 (24 bits) al outbound interrupt mailbox. A diferencia de
+ * send_event, lv2 no responde en el inbound mailbox, que queda libre
+ * para los jobs.
+ */
+static void throw_event(unsigned int port, unsigned int data0, unsigned int data1)
+{
+    spu_write_out_mbox(data1);
+    spu_write_out_intr_mbox(((0x40 | port) << 24) | (data0 & 0x00ffffff));
+}
+
+/*
+ * Avisa el fin de un job con el quadword de estado. Antes de tocar el
+ * buffer se espera el put anterior (normalmente terminado hace rato); el
+ * nuevo no se espera, asi el SPU vuelve enseguida al mailbox. Los kernels
+ * esperan sus propios tags antes de volver, asi que los resultados ya estan
+ * en memoria; el fence mantiene ademas cada estado detras del anterior.
+ */
+static void put_status(uint64_t ea, unsigned int seq, unsigned int kernel, unsigned int size)
+{
+    static vecmath_status_t status __attribute__((aligned(16)));
+
+    wait_for_tag(TAG_STATUS);
+    status.seq    = seq;
+    status.kernel = kernel;
+    status.size   = size;
+    mfc_putf(&status, ea, sizeof(status), TAG_STATUS, 0, 0);
+}
+
+/* Kernel QUEUE: procesa rangos hasta vaciar la cola; devuelve cuantos proceso */
+static unsigned int run_queue(uint64_t ea_queue)
+{
+    unsigned int total = 0;
+    unsigned int start, n;
+
+    while ((n = claim_range(ea_queue, (volatile unsigned int *)&queue_line, &start)) != 0) {
+        uint64_t ea = queue_line.ea_vecs + (uint64_t)start * sizeof(vecmath_vec_t);
+
+        run_batch(ea, n, clamp_chunk(queue_line.chunk));
+        total += n;
+    }
+    return total;
+}
+
+/*
+ * Arma en gather_list[buf] la lista de los elementos [start, start + n)
+ * del descriptor en gather_line. Con indices, primero los trae desde el
+ * quadword que contiene al primero.
+ */
+static void build_list(unsigned int buf, unsigned int start, unsigned int n)
+{
+    const unsigned int *index = 0;
+    unsigned int i;
+
+    if (gather_line.ea_index) {
+        uint64_t ea      = gather_line.ea_index + (uint64_t)start * 4;
+        unsigned int skip = (unsigned int)(ea & 15) / 4;
+
+        mfc_get(gather_index[buf], ea & ~15ULL, ((skip + n) * 4 + 15) & ~15,
+                TAG_INDEX, 0, 0);
+        wait_for_tag(TAG_INDEX);
+        index = gather_index[buf] + skip;
+    }
+
+    for (i = 0; i < n; i++) {
+        unsigned int r = index ? index[i] : start + i;
+
+        gather_list[buf][i].notify   = 0;
+        gather_list[buf][i].reserved = 0;
+        gather_list[buf][i].size     = sizeof(vecmath_vec_t);
+        gather_list[buf][i].eal      = gather_line.ea_base + r * gather_line.stride +
+                                       gather_line.offset;
+    }
+}
+
+/*
+ * Gather de 'count' elementos a partir de 'start', en chunks con doble
+ * buffer como run_batch(). La lista de un buffer sigue en uso hasta que
+ * termina su putl, asi que antes de rearmarla se espera ese tag en vez de
+ * usar un get con barrera.
+ */
+static void run_gather(unsigned int start, unsigned int count, unsigned int chunk)
+{
+    unsigned int cur  = 0;
+    unsigned int done = 0;
+    unsigned int n    = count < chunk ? count : chunk;
+
+    build_list(cur, start, n);
+    mfc_getl(batch_buf[cur], 0, gather_list[cur], n * sizeof(mfc_list_element_t),
+             TAG_BUF + cur, 0, 0);
+
+    while (done < count) {
+        unsigned int next = done + n;
+        unsigned int nn   = 0;
+
+        if (next < count) {
+            nn = count - next < chunk ? count - next : chunk;
+            wait_for_tag(TAG_BUF + (cur ^ 1));
+            build_list(cur ^ 1, start + next, nn);
+            mfc_getl(batch_buf[cur ^ 1], 0, gather_list[cur ^ 1],
+                     nn * sizeof(mfc_list_element_t), TAG_BUF + (cur ^ 1), 0, 0);
+        }
+
+        wait_for_tag(TAG_BUF + cur);
+        process_chunk(batch_buf[cur], n);
+        mfc_putl(batch_buf[cur], 0, gather_list[cur], n * sizeof(mfc_list_element_t),
+                 TAG_BUF + cur, 0, 0);
+
+        done = next;
+        n    = nn;
+        cur ^= 1;
+    }
+
+    mfc_write_tag_mask((1 << TAG_BUF) | (1 << (TAG_BUF + 1)));
+    spu_mfcstat(MFC_TAG_UPDATE_ALL);
+}
+
+/* Kernels residentes, con la firma comun de la tabla */
+static unsigned int kernel_single(uint64_t ea, unsigned int size, unsigned int cmd)
+{
+    run_single(ea);
+    return size;
+}
+
+static unsigned int kernel_batch(uint64_t ea, unsigned int size, unsigned int cmd)
+{
+    if (size)
+        run_batch(ea, size, clamp_chunk(VECMATH_JOB_CHUNK(cmd)));
+    return size;
+}
+
+static unsigned int kernel_queue(uint64_t ea, unsigned int size, unsigned int cmd)
+{
+    return run_queue(ea);
+}
+
+static unsigned int kernel_gather(uint64_t ea, unsigned int size, unsigned int cmd)
+{
+    unsigned int total = 0;
+    unsigned int start, n;
+
+    while ((n = claim_range(ea, (volatile unsigned int *)&gather_line, &start)) != 0) {
+        run_gather(start, n, clamp_chunk(gather_line.chunk));
+        total += n;
+    }
+    return total;
+}
+
+/*
+ * Tabla de kernels indexada por el id del comando. Los que tienen overlay
+ * se resuelven con overlay_load() al llegar el job; agregar un kernel es
+ * agregar una entrada (y su binario, si no entra en la imagen).
+ */
+#define NO_OVERLAY  0xffffffff
+
+static const struct {
+    spu_kernel_fn fn;
+    unsigned int  overlay;
+} kernels[VECMATH_KERNEL_COUNT] = {
+    [VECMATH_KERNEL_QUIT]   = { 0,             NO_OVERLAY },
+    [VECMATH_KERNEL_SINGLE] = { kernel_single, NO_OVERLAY },
+    [VECMATH_KERNEL_BATCH]  = { kernel_batch,  NO_OVERLAY },
+    [VECMATH_KERNEL_QUEUE]  = { kernel_queue,  NO_OVERLAY },
+    [VECMATH_KERNEL_TILES]  = { 0,             VECMATH_OVERLAY_TILES },
+    [VECMATH_KERNEL_SOA]    = { 0,             VECMATH_OVERLAY_SOA },
+    [VECMATH_KERNEL_GATHER] = { kernel_gather, NO_OVERLAY },
+};
+
+/* Ejecuta un job; un kernel desconocido o sin overlay no procesa nada */
+static unsigned int run_kernel(unsigned int kernel, uint64_t ea, unsigned int size,
+                               unsigned int cmd)
+{
+    spu_kernel_fn fn;
+
+    if (kernel >= VECMATH_KERNEL_COUNT)
+        return 0;
+
+    fn = kernels[kernel].fn;
+    if (kernels[kernel].overlay != NO_OVERLAY)
+        fn = overlay_load(kernels[kernel].overlay);
+    return fn ? fn(ea, size, cmd) : 0;
+}
+
+/*
+ * Loop del worker residente: un job por cada 3 palabras del mailbox.
+ * 'ea_status' es el quadword de estado de este thread y 'ea_overlays' la
+ * tabla de overlays.
+ */
+static void run_worker(uint64_t ea_status, uint64_t ea_overlays)
+{
+    unsigned int seq = 0;
+
+    overlay_init(ea_overlays);
+
+    /* El decrementer mide el tiempo por tile del kernel TILES */
+    spu_write_decrementer(0xffffffff);
+
+    for (;;) {
+        unsigned int cmd    = spu_read_in_mbox();
+        unsigned int kernel = VECMATH_JOB_KERNEL(cmd);
+        unsigned int ea, size;
+
+        if (kernel == VECMATH_KERNEL_QUIT)
+            break;
+
+        ea   = spu_read_in_mbox();
+        size = spu_read_in_mbox();
+
+        size = run_kernel(kernel, ea, size, cmd);
+
+        /* seq avanza en cada job para seguir la cuenta del PPU */
+        seq++;
+        if (cmd & VECMATH_JOB_STATUS)
+            put_status(ea_status, seq, kernel, size);
+        else
+            throw_event(VECMATH_EVENT_PORT, kernel, size);
+    }
+
+    wait_for_tag(TAG_STATUS);
+}
+
+int main(uint64_t ea_data, uint64_t count, uint64_t chunk, uint64_t mode)
+{
+    if (mode == VECMATH_MODE_WORKER)
+        run_worker(ea_data + count * sizeof(vecmath_status_t), chunk);
+    else if (count == 0)
+        run_single(ea_data);
+    else
+        run_batch(ea_data, (unsigned int)count, clamp_chunk((unsigned int)chunk));
 
     spu_thread_exit(0);
     return 0;
@@ -0,0 +1,75 @@
+/*
+ * Cargador de overlays del programa SPU.
+ *
+ * Un solo overlay esta residente a la vez en [SPU_OVERLAY_BASE,
+ * SPU_OVERLAY_BASE + SPU_OVERLAY_SIZE). Pedir el que ya esta cargado no
+ * cuesta nada; cambiar de overlay es un DMA del binario (trozos de 16 KB),
+ * poner a cero su bss y un sync para que el SPU no ejecute instrucciones
+ * viejas de la region.
+ */
+#include <string.h>
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+
+#include "vecmath.h"
+#include "spu_common.h"
+
+#define OVERLAY_NONE    0xffffffff
+
+static vecmath_overlay_t table[VECMATH_OVERLAYS] __attribute__((aligned(128)));
+static unsigned int resident = OVERLAY_NONE;
+static unsigned int available;
+
+/* Fin de la imagen residente, definido por el linker */
+extern char _end[];
+
+void overlay_init(uint64_t ea_table)
+{
+    char *sp   = __builtin_frame_address(0);
+    char *base = (char *)SPU_OVERLAY_BASE;
+
+    resident  = OVERLAY_NONE;
+    available = 0;
+    if (!ea_table)
+        return;
+
+    /* La imagen y el stack no pueden pisar la region */
+    if (_end > base || sp < base + SPU_OVERLAY_SIZE)
+        return;
+
+    mfc_get(table, ea_table, sizeof(table), TAG_OVL, 0, 0);
+    wait_for_tag(TAG_OVL);
+    available = 1;
+}
+
+spu_kernel_fn overlay_load(unsigned int id)
+{
+    spu_overlay_header_t *hdr = (spu_overlay_header_t *)SPU_OVERLAY_BASE;
+    unsigned int size, off;
+
+    if (!available || id >= VECMATH_OVERLAYS)
+        return 0;
+    if (id == resident)
+        return hdr->entry;
+
+    size = (table[id].size + 15) & ~15;
+    if (!table[id].ea || size < sizeof(*hdr) || size > SPU_OVERLAY_SIZE)
+        return 0;
+
+    /* Si la carga falla la region queda invalida */
+    resident = OVERLAY_NONE;
+    for (off = 0; off < size; off += 16384) {
+        unsigned int n = size - off < 16384 ? size - off : 16384;
+        mfc_get((char *)SPU_OVERLAY_BASE + off, table[id].ea + off, n, TAG_OVL, 0, 0);
+    }
+    wait_for_tag(TAG_OVL);
+
+    if (hdr->magic != SPU_OVERLAY_MAGIC ||
+        hdr->bss_end > (char *)SPU_OVERLAY_BASE + SPU_OVERLAY_SIZE)
+        return 0;
+    memset(hdr->bss_start, 0, hdr->bss_end - hdr->bss_start);
+
+    spu_sync();
+    resident = id;
+    return hdr->entry;
+}
@@ -0,0 +1,235 @@
+/*
+ * Kernel SOA: batch en planos x/y/z/w (ver vecmath_soa_t en vecmath.h).
+ *
+ * Cada SPU reclama rangos de la cabecera con claim_range() y los recorre
+ * en chunks de hasta VECMATH_SOA_CHUNK vectores con doble buffer: un get
+ * por plano de entrada, el calculo sobre quadwords (4 vectores a la vez,
+ * sin shuffles) y un put por plano de salida pedido en 'flags'. La
+ * operacion y la precision salen de la cabecera (ver spumath.h).
+ *
+ * Se enlaza como overlay (overlay.ld), no dentro de la imagen residente.
+ */
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+
+#include "vecmath.h"
+#include "spumath.h"
+#include "spu_common.h"
+
+#define SOA_QW  (VECMATH_SOA_CHUNK / 4)
+
+static vecmath_soa_t soa_line __attribute__((aligned(128)));
+
+static vector float in_buf[2][4][SOA_QW] __attribute__((aligned(128)));
+static vector float out_buf[2][6][SOA_QW] __attribute__((aligned(128)));
+
+/* operand[] de la cabecera, cada elemento replicado en un quadword */
+static vector float operand_rep[16];
+
+/* Salida i de out_buf -> plano en memoria principal */
+static const unsigned int out_plane[6] = {
+    VECMATH_SOA_OUT_X, VECMATH_SOA_OUT_Y, VECMATH_SOA_OUT_Z, VECMATH_SOA_OUT_W,
+    VECMATH_SOA_DOT, VECMATH_SOA_MAG,
+};
+
+static inline uint64_t plane_ea(uint64_t ea_soa, unsigned int plane, unsigned int first)
+{
+    return ea_soa + sizeof(vecmath_soa_t) +
+           ((uint64_t)plane * soa_line.stride + first) * sizeof(float);
+}
+
+static void get_chunk(uint64_t ea_soa, unsigned int b, unsigned int first, unsigned int n)
+{
+    unsigned int p;
+
+    for (p = 0; p < 4; p++)
+        mfc_get(in_buf[b][p], plane_ea(ea_soa, VECMATH_SOA_X + p, first),
+                n * sizeof(float), TAG_SOA + b, 0, 0);
+}
+
+static void put_chunk(uint64_t ea_soa, unsigned int b, unsigned int first,
+                      unsigned int n, unsigned int flags)
+{
+    unsigned int i;
+
+    for (i = 0; i < 6; i++) {
+        if (i < 4 && !(flags & VECMATH_SOA_OUT_XYZW))
+            continue;
+        if (i == 4 && !(flags & VECMATH_SOA_OUT_DOT))
+            continue;
+        if (i == 5 && !(flags & VECMATH_SOA_OUT_MAG))
+            continue;
+        mfc_put(out_buf[b][i], plane_ea(ea_soa, out_plane[i], first),
+                n * sizeof(float), TAG_SOA + b, 0, 0);
+    }
+}
+
+/*
+ * Un loop por operacion; elemento k de cada quadword es el vector k. Se
+ * inlinean con 'prec' constante desde compute_chunk().
+ */
+#define SOA_LOOP(b, n)                                                  \
+    vector float (*in)[SOA_QW]  = in_buf[b];                           \
+    vector float (*out)[SOA_QW] = out_buf[b];                          \
+    unsigned int q;                                                     \
+    for (q = 0; q < (n) / 4; q++)
+
+static inline __attribute__((always_inline))
+void op_vecmath(unsigned int b, unsigned int n, unsigned int prec)
+{
+    SOA_LOOP(b, n) {
+        vector float sx = spu_mul(in[0][q], in[0][q]);
+        vector float sy = spu_mul(in[1][q], in[1][q]);
+        vector float sz = spu_mul(in[2][q], in[2][q]);
+        vector float sw = spu_mul(in[3][q], in[3][q]);
+        vector float dot = spu_add(spu_add(sx, sy), spu_add(sz, sw));
+
+        out[0][q] = sx;
+        out[1][q] = sy;
+        out[2][q] = sz;
+        out[3][q] = sw;
+        out[4][q] = dot;
+        out[5][q] = spumath_sqrt(dot, prec);
+    }
+}
+
+static inline __attribute__((always_inline))
+void op_normalize(unsigned int b, unsigned int n, unsigned int prec)
+{
+    SOA_LOOP(b, n) {
+        vector float v[4] = { in[0][q], in[1][q], in[2][q], in[3][q] };
+        vector float len2;
+        vector float inv = spumath_normalize4(v, &len2, prec);
+
+        out[0][q] = v[0];
+        out[1][q] = v[1];
+        out[2][q] = v[2];
+        out[3][q] = v[3];
+        out[4][q] = len2;
+        out[5][q] = spu_mul(len2, inv);
+    }
+}
+
+static void op_dot(unsigned int b, unsigned int n)
+{
+    const vector float *k = operand_rep;
+
+    SOA_LOOP(b, n) {
+        out[4][q] = spumath_dot4(in[0][q], in[1][q], in[2][q], in[3][q],
+                                 k[0], k[1], k[2], k[3]);
+    }
+}
+
+static void op_cross(unsigned int b, unsigned int n)
+{
+    const vector float *k = operand_rep;
+
+    SOA_LOOP(b, n) {
+        vector float c[3];
+
+        spumath_cross3(in[0][q], in[1][q], in[2][q], k[0], k[1], k[2], c);
+        out[0][q] = c[0];
+        out[1][q] = c[1];
+        out[2][q] = c[2];
+        out[3][q] = spu_splats(0.0f);
+    }
+}
+
+static void op_transform(unsigned int b, unsigned int n)
+{
+    SOA_LOOP(b, n) {
+        vector float t[4];
+
+        spumath_transform4(operand_rep, in[0][q], in[1][q], in[2][q], in[3][q], t);
+        out[0][q] = t[0];
+        out[1][q] = t[1];
+        out[2][q] = t[2];
+        out[3][q] = t[3];
+    }
+}
+
+#define SOA_PREC(fn, b, n)                                              \
+    switch (soa_line.prec) {                                            \
+    case VECMATH_PREC_ESTIMATE: fn(b, n, VECMATH_PREC_ESTIMATE); break; \
+    case VECMATH_PREC_NEWTON:   fn(b, n, VECMATH_PREC_NEWTON);   break; \
+    default:                    fn(b, n, VECMATH_PREC_FULL);     break; \
+    }
+
+static void compute_chunk(unsigned int b, unsigned int n)
+{
+    switch (soa_line.op) {
+    case VECMATH_OP_NORMALIZE:
+        SOA_PREC(op_normalize, b, n);
+        break;
+    case VECMATH_OP_DOT:
+        op_dot(b, n);
+        break;
+    case VECMATH_OP_CROSS:
+        op_cross(b, n);
+        break;
+    case VECMATH_OP_TRANSFORM:
+        op_transform(b, n);
+        break;
+    default:
+        SOA_PREC(op_vecmath, b, n);
+        break;
+    }
+}
+
+/*
+ * Recorre [start, start + count) con doble buffer, como run_batch(). Los
+ * puts del chunk anterior de un buffer van con su mismo tag, asi que
+ * esperar el get tambien garantiza que out_buf se puede reescribir.
+ */
+static void run_range(uint64_t ea_soa, unsigned int start, unsigned int count,
+                      unsigned int flags)
+{
+    unsigned int cur  = 0;
+    unsigned int done = 0;
+    unsigned int n    = count < VECMATH_SOA_CHUNK ? count : VECMATH_SOA_CHUNK;
+
+    get_chunk(ea_soa, cur, start, n);
+
+    while (done < count) {
+        unsigned int next = done + n;
+        unsigned int nn   = 0;
+
+        if (next < count) {
+            nn = count - next < VECMATH_SOA_CHUNK ? count - next : VECMATH_SOA_CHUNK;
+            get_chunk(ea_soa, cur ^ 1, start + next, nn);
+        }
+
+        wait_for_tag(TAG_SOA + cur);
+        compute_chunk(cur, n);
+        put_chunk(ea_soa, cur, start + done, n, flags);
+
+        done = next;
+        n    = nn;
+        cur ^= 1;
+    }
+
+    mfc_write_tag_mask((1 << TAG_SOA) | (1 << (TAG_SOA + 1)));
+    spu_mfcstat(MFC_TAG_UPDATE_ALL);
+}
+
+static unsigned int run_soa(uint64_t ea_soa, unsigned int size, unsigned int cmd)
+{
+    unsigned int total = 0;
+    unsigned int start, n, i;
+
+    while ((n = claim_range(ea_soa, (volatile unsigned int *)&soa_line, &start)) != 0) {
+        if (total == 0) {
+            for (i = 0; i < 16; i++)
+                operand_rep[i] = spu_splats(soa_line.operand[i]);
+        }
+
+        /* Los planos se procesan por quadwords: el ultimo rango se completa
+         * hasta multiplo de 4 dentro del relleno de 'stride' */
+        run_range(ea_soa, start, (n + 3) & ~3, soa_line.flags);
+        total += n;
+    }
+    return total;
+}
+
+/* Entrada del overlay (ver overlay.ld) */
+SPU_OVERLAY(run_soa);
@@ -0,0 +1,76 @@
+#ifndef __SPU_COMMON_H__
+#define __SPU_COMMON_H__
+
+/*
+ * Utilidades compartidas por los kernels del programa SPU (main.c).
+ */
+#include <stdint.h>
+
+/* Tags DMA: cada kernel usa los suyos para no esperar transferencias ajenas */
+#define TAG         1   /* modo simple */
+#define TAG_BUF     2   /* modo batch: tags 2 y 3, uno por buffer */
+#define TAG_TILE    4   /* tiles: tags 4 y 5, uno por buffer */
+#define TAG_CMDS    6   /* tiles: display list */
+#define TAG_SOA     8   /* batch SoA: tags 8 y 9, uno por buffer */
+#define TAG_STATUS  10  /* quadword de estado del worker */
+#define TAG_OVL     11  /* carga de overlays */
+#define TAG_INDEX   12  /* gather: indices de registro */
+
+/*
+ * Region de LS reservada para overlays: por debajo queda la imagen
+ * residente y por encima el stack. El Makefile pasa los mismos valores al
+ * linker de los overlays (overlay.ld).
+ */
+#ifndef SPU_OVERLAY_BASE
+#define SPU_OVERLAY_BASE    0x28000
+#endif
+#ifndef SPU_OVERLAY_SIZE
+#define SPU_OVERLAY_SIZE    0x10000
+#endif
+
+#define SPU_OVERLAY_MAGIC   0x4f564c31  /* "OVL1" */
+
+/* Un kernel: EA y tamano del job, y la palabra de comando completa */
+typedef unsigned int (*spu_kernel_fn)(uint64_t ea, unsigned int size, unsigned int cmd);
+
+/*
+ * Cabecera al principio de cada overlay (seccion .ovl_header, ver
+ * overlay.ld). El bss no viaja en el binario: el cargador lo pone a cero.
+ */
+typedef struct {
+    unsigned int magic;
+    spu_kernel_fn entry;
+    char *bss_start;
+    char *bss_end;
+} spu_overlay_header_t;
+
+#ifndef SPU_HOST
+#define SPU_OVERLAY(fn)                                                 \
+    extern char __ovl_bss_start[], __ovl_end[];                         \
+    const spu_overlay_header_t spu_overlay_header                       \
+        __attribute__((section(".ovl_header"), used)) =                 \
+        { SPU_OVERLAY_MAGIC, fn, __ovl_bss_start, __ovl_end }
+#else
+/* Build nativo (host/spu): el overlay se enlaza y exporta su entrada */
+#define SPU_OVERLAY(fn) const spu_kernel_fn spu_host_overlay_##fn = fn
+#endif
+
+void wait_for_tag(unsigned int tag);
+
+/*
+ * Reclamo atomico sobre una linea de 128 bytes en memoria principal cuyas
+ * tres primeras palabras son next/count/grain. 'line' es el buffer de LS
+ * (alineado a 128) donde se hace la reserva. Devuelve cuantos elementos
+ * se reclamaron a partir de *start (0 = no queda nada).
+ */
+unsigned int claim_range(uint64_t ea, volatile unsigned int *line, unsigned int *start);
+
+/*
+ * Cargador de overlays (overlay.c). overlay_init trae la tabla de
+ * vecmath_overlay_t (EA 0 = sin overlays); overlay_load deja el overlay
+ * 'id' en la region y devuelve su entrada, o 0 si no se pudo cargar.
+ */
+void overlay_init(uint64_t ea_table);
+spu_kernel_fn overlay_load(unsigned int id);
+
+#endif
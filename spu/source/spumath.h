@@ -0,0 +1,104 @@
+#ifndef __SPUMATH_H__
+#define __SPUMATH_H__
+
+/*
+ * Matematica vectorial del SPU en tres niveles de precision (ver
+ * VECMATH_PREC_* en vecmath.h):
+ *
+ *   ESTIMATE: solo frsqest (spu_rsqrte), ~12 bits
+ *   NEWTON:   estimacion + un paso de Newton-Raphson, ~22-23 bits
+ *   FULL:     dos pasos (rsqrt) o paso + correccion del residuo (sqrt),
+ *             a 1-2 ulp (el SPU redondea por truncamiento)
+ *
+ * Todas las funciones trabajan sobre quadwords: en formato SoA cada
+ * elemento es un vector distinto, asi que no hay shuffles. 'prec' es una
+ * constante en cada llamador, asi que el switch desaparece al inlinear.
+ *
+ * sqrt(0) y normalize(0) devuelven 0 (dot * rsqrte(dot) daba NaN).
+ */
+#include <spu_intrinsics.h>
+
+#include "vecmath.h"
+
+/* Un paso de Newton-Raphson para 1/sqrt(x): y += y/2 * (1 - x*y*y) */
+static inline vector float spumath_rsqrt_step(vector float x, vector float y)
+{
+    vector float e = spu_nmsub(spu_mul(x, y), y, spu_splats(1.0f));
+    return spu_madd(spu_mul(y, spu_splats(0.5f)), e, y);
+}
+
+static inline vector float spumath_rsqrt(vector float x, unsigned int prec)
+{
+    vector float y = spu_rsqrte(x);
+
+    if (prec >= VECMATH_PREC_NEWTON)
+        y = spumath_rsqrt_step(x, y);
+    if (prec >= VECMATH_PREC_FULL)
+        y = spumath_rsqrt_step(x, y);
+    return y;
+}
+
+static inline vector float spumath_sqrt(vector float x, unsigned int prec)
+{
+    vector float y = spumath_rsqrt(x, prec);
+    vector float s = spu_mul(x, y);
+
+    /* Correccion con el residuo: s += y/2 * (x - s*s) */
+    if (prec >= VECMATH_PREC_FULL)
+        s = spu_madd(spu_mul(y, spu_splats(0.5f)), spu_nmsub(s, s, x), s);
+
+    return spu_sel(s, spu_splats(0.0f), spu_cmpeq(x, spu_splats(0.0f)));
+}
+
+/* Producto punto de 4 vectores SoA contra otros 4 (o una constante replicada) */
+static inline vector float spumath_dot4(vector float x, vector float y,
+                                        vector float z, vector float w,
+                                        vector float kx, vector float ky,
+                                        vector float kz, vector float kw)
+{
+    return spu_madd(x, kx, spu_madd(y, ky, spu_madd(z, kz, spu_mul(w, kw))));
+}
+
+/* a x b sobre tres componentes */
+static inline void spumath_cross3(vector float ax, vector float ay, vector float az,
+                                  vector float bx, vector float by, vector float bz,
+                                  vector float out[3])
+{
+    out[0] = spu_msub(ay, bz, spu_mul(az, by));
+    out[1] = spu_msub(az, bx, spu_mul(ax, bz));
+    out[2] = spu_msub(ax, by, spu_mul(ay, bx));
+}
+
+/*
+ * v / |v| para 4 componentes; 'len2' recibe |v|^2. Devuelve 1/|v| (0 para
+ * un vector nulo, que queda nulo en vez de NaN).
+ */
+static inline vector float spumath_normalize4(vector float v[4], vector float *len2,
+                                              unsigned int prec)
+{
+    vector float d   = spumath_dot4(v[0], v[1], v[2], v[3], v[0], v[1], v[2], v[3]);
+    vector float inv = spumath_rsqrt(d, prec);
+    unsigned int i;
+
+    inv = spu_sel(inv, spu_splats(0.0f), spu_cmpeq(d, spu_splats(0.0f)));
+    for (i = 0; i < 4; i++)
+        v[i] = spu_mul(v[i], inv);
+    *len2 = d;
+    return inv;
+}
+
+/*
+ * out = M * v con M de 4x4 por filas, cada elemento ya replicado en un
+ * quadword (m[fila * 4 + columna]).
+ */
+static inline void spumath_transform4(const vector float m[16], vector float x,
+                                      vector float y, vector float z, vector float w,
+                                      vector float out[4])
+{
+    unsigned int r;
+
+    for (r = 0; r < 4; r++)
+        out[r] = spumath_dot4(x, y, z, w, m[r * 4], m[r * 4 + 1], m[r * 4 + 2], m[r * 4 + 3]);
+}
+
+#endif
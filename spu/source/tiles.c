@@ -0,0 +1,228 @@
+/*
+ * Kernel TILES: rasterizado de la display list de texto por tiles.
+ *
+ * Cada SPU reclama tiles del frame con claim_range(). Para cada tile se
+ * juntan los comandos que lo tocan; si ninguno lo toca el tile no se
+ * transfiere. Si no, se trae a LS (salvo que el primer comando sea un
+ * relleno que lo cubre entero), se aplican los comandos en orden con
+ * stores de 128 bits y se devuelve con put. Los tiles alternan entre dos
+ * buffers para que el put de uno se solape con el siguiente tile.
+ *
+ * Se enlaza como overlay (overlay.ld), no dentro de la imagen residente.
+ */
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+
+#include "font8x8.h"
+#include "spudraw.h"
+#include "spu_common.h"
+
+static spudraw_frame_t frame_line __attribute__((aligned(128)));
+static spudraw_cmd_t   cmds[SPUDRAW_MAX_CMDS] __attribute__((aligned(128)));
+static unsigned short  hits[SPUDRAW_MAX_CMDS];
+static unsigned int    cmd_count;
+
+static unsigned int tile_buf[2][SPUDRAW_TILE_H][SPUDRAW_TILE_W] __attribute__((aligned(128)));
+
+/* Ticks por tile: un quadword por buffer, se escribe el elemento (tile & 3)
+ * para que LS y EA tengan la misma alineacion dentro de los 16 bytes */
+static unsigned int ticks_ls[2][4] __attribute__((aligned(16)));
+
+static void load_cmds(void)
+{
+    unsigned int count = frame_line.cmd_count;
+    unsigned int bytes, off;
+
+    if (count > SPUDRAW_MAX_CMDS)
+        count = SPUDRAW_MAX_CMDS;
+    bytes = count * sizeof(spudraw_cmd_t);
+
+    /* Una transferencia DMA no puede superar 16 KB */
+    for (off = 0; off < bytes; off += 16384) {
+        unsigned int n = bytes - off < 16384 ? bytes - off : 16384;
+        mfc_get((char *)cmds + off, frame_line.cmds_ea + off, n, TAG_CMDS, 0, 0);
+    }
+    wait_for_tag(TAG_CMDS);
+    cmd_count = count;
+}
+
+/*
+ * Escribe 'color' en los pixeles [a, b) de una fila del tile. Los
+ * quadwords completos se guardan directo; los de los bordes se mezclan
+ * con spu_sel usando una mascara por elemento.
+ */
+static void store_span(unsigned int *row, int a, int b, vector unsigned int vcol)
+{
+    static const vector signed int lane_idx = { 0, 1, 2, 3 };
+    vector unsigned int *q = (vector unsigned int *)row;
+    vector signed int va = spu_splats(a);
+    vector signed int vb = spu_splats(b);
+    int qi;
+
+    for (qi = a >> 2; qi < (b + 3) >> 2; qi++) {
+        int base = qi << 2;
+
+        if (base >= a && base + 4 <= b) {
+            q[qi] = vcol;
+        } else {
+            vector signed int lane = spu_add(spu_splats(base), lane_idx);
+            vector unsigned int m  = spu_andc(spu_cmpgt(vb, lane), spu_cmpgt(va, lane));
+            q[qi] = spu_sel(q[qi], vcol, m);
+        }
+    }
+}
+
+static void raster_fill(unsigned int (*tile)[SPUDRAW_TILE_W], const spudraw_cmd_t *c,
+                        int tx0, int ty0, int tw, int th)
+{
+    vector unsigned int vcol = spu_splats(c->color);
+    int x0 = (int)c->x - tx0, x1 = x0 + c->w;
+    int y0 = (int)c->y - ty0, y1 = y0 + c->h;
+    int y;
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > tw) x1 = tw;
+    if (y1 > th) y1 = th;
+
+    for (y = y0; y < y1; y++)
+        store_span(tile[y], x0, x1, vcol);
+}
+
+static void raster_glyph(unsigned int (*tile)[SPUDRAW_TILE_W], const spudraw_cmd_t *c,
+                         int tx0, int ty0, int tw, int th)
+{
+    vector unsigned int vcol = spu_splats(c->color);
+    const unsigned char *glyph = font8x8[c->ch - FONT_FIRST];
+    int s  = c->scale;
+    int gx = (int)c->x - tx0;
+    int gy = (int)c->y - ty0;
+    int r;
+
+    for (r = 0; r < FONT_H; r++) {
+        unsigned int bits = glyph[r];
+        int y0 = gy + r * s, y1 = y0 + s;
+        int col = 0;
+
+        if (!bits || y1 <= 0 || y0 >= th)
+            continue;
+        if (y0 < 0) y0 = 0;
+        if (y1 > th) y1 = th;
+
+        /* Un span por cada run de bits encendidos */
+        while (col < FONT_W) {
+            int start, a, b, y;
+
+            if (!(bits & (0x80 >> col))) {
+                col++;
+                continue;
+            }
+            start = col;
+            while (col < FONT_W && (bits & (0x80 >> col)))
+                col++;
+
+            a = gx + start * s;
+            b = gx + col * s;
+            if (a < 0) a = 0;
+            if (b > tw) b = tw;
+            if (a >= b)
+                continue;
+
+            for (y = y0; y < y1; y++)
+                store_span(tile[y], a, b, vcol);
+        }
+    }
+}
+
+/* Indices de los comandos que tocan el tile; *covered = el primero lo tapa entero */
+static unsigned int collect(int tx0, int ty0, int tw, int th, int *covered)
+{
+    unsigned int i, n = 0;
+
+    *covered = 0;
+    for (i = 0; i < cmd_count; i++) {
+        const spudraw_cmd_t *c = &cmds[i];
+        int x = c->x, y = c->y;
+        int w = c->kind == SPUDRAW_CMD_FILL ? c->w : FONT_W * c->scale;
+        int h = c->kind == SPUDRAW_CMD_FILL ? c->h : FONT_H * c->scale;
+
+        if (x >= tx0 + tw || y >= ty0 + th || x + w <= tx0 || y + h <= ty0)
+            continue;
+
+        if (n == 0 && c->kind == SPUDRAW_CMD_FILL &&
+            x <= tx0 && y <= ty0 && x + w >= tx0 + tw && y + h >= ty0 + th)
+            *covered = 1;
+        hits[n++] = (unsigned short)i;
+    }
+    return n;
+}
+
+static unsigned int run_tiles(uint64_t ea_frame, unsigned int size, unsigned int cmd)
+{
+    unsigned int cur = 0, drawn = 0, loaded = 0;
+    unsigned int start, take, tile;
+
+    /* Cada reclamo trae 'grain' tiles seguidos; se dibujan todos */
+    while ((take = claim_range(ea_frame, (volatile unsigned int *)&frame_line, &start)) != 0) {
+        for (tile = start; tile < start + take; tile++) {
+            unsigned int (*buf)[SPUDRAW_TILE_W] = tile_buf[cur];
+            unsigned int t0 = spu_read_decrementer();
+            int tx0 = (int)(tile % frame_line.tiles_x) * SPUDRAW_TILE_W;
+            int ty0 = (int)(tile / frame_line.tiles_x) * SPUDRAW_TILE_H;
+            int tw  = (int)frame_line.width  - tx0;
+            int th  = (int)frame_line.height - ty0;
+            unsigned int n, i;
+            int covered, r;
+
+            if (!loaded) {
+                load_cmds();
+                loaded = 1;
+            }
+
+            if (tw > SPUDRAW_TILE_W) tw = SPUDRAW_TILE_W;
+            if (th > SPUDRAW_TILE_H) th = SPUDRAW_TILE_H;
+
+            n = collect(tx0, ty0, tw, th, &covered);
+            if (n == 0)
+                continue;
+
+            /* El put anterior desde este buffer tiene que haber terminado */
+            wait_for_tag(TAG_TILE + cur);
+
+            if (!covered) {
+                for (r = 0; r < th; r++)
+                    mfc_get(buf[r], frame_line.fb_ea + (ty0 + r) * frame_line.pitch + tx0 * 4,
+                            tw * 4, TAG_TILE + cur, 0, 0);
+                wait_for_tag(TAG_TILE + cur);
+            }
+
+            for (i = 0; i < n; i++) {
+                const spudraw_cmd_t *c = &cmds[hits[i]];
+                if (c->kind == SPUDRAW_CMD_FILL)
+                    raster_fill(buf, c, tx0, ty0, tw, th);
+                else
+                    raster_glyph(buf, c, tx0, ty0, tw, th);
+            }
+
+            for (r = 0; r < th; r++)
+                mfc_put(buf[r], frame_line.fb_ea + (ty0 + r) * frame_line.pitch + tx0 * 4,
+                        tw * 4, TAG_TILE + cur, 0, 0);
+
+            if (frame_line.ticks_ea) {
+                ticks_ls[cur][tile & 3] = t0 - spu_read_decrementer();
+                mfc_put(&ticks_ls[cur][tile & 3], frame_line.ticks_ea + tile * 4,
+                        4, TAG_TILE + cur, 0, 0);
+            }
+
+            cur ^= 1;
+            drawn++;
+        }
+    }
+
+    mfc_write_tag_mask((1 << TAG_TILE) | (1 << (TAG_TILE + 1)));
+    spu_mfcstat(MFC_TAG_UPDATE_ALL);
+    return drawn;
+}
+
+/* Entrada del overlay (ver overlay.ld) */
+SPU_OVERLAY(run_tiles);
@@ -0,0 +1,745 @@
+/*
+ * Startup benchmarks (make BENCH=1). Each benchmark prints one line per
+ * configuration so results can be grepped out of the TTY log.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "bench.h"
+#include "benchdata.h"
+#include "fill.h"
+#include "glyph.h"
+#include "headless.h"
+#include "rsxdraw.h"
+#include "spuraster.h"
+#include "textlayer.h"
+#include "spe.h"
+#include "spudraw.h"
+#include "timer.h"
+#include "vecmath.h"
+#include "vecmath_gather.h"
+#include "vecmath_ref.h"
+#include "vecmath_soa.h"
+
+#define BENCH_VECTORS   16384
+#define BENCH_RUNS      3
+#define BENCH_JOBS      200
+#define BENCH_SCALE_VECTORS (256 * 1024)
+#define BENCH_RELOADS   20
+#define BENCH_GATHER_VECTORS 16384
+
+#define BENCH_FB_W      1280
+#define BENCH_FB_H      720
+#define BENCH_GLYPHS    20000
+#define BENCH_FRAMES    120
+#define BENCH_FILLS     60
+
+extern const unsigned int spu_bin[];
+
+static const u32 bench_chunks[] = { 8, 16, 32, 64, 128, 256 };
+static const u32 bench_scales[] = { 1, 2, 4 };
+
+static void fillVectors(vecmath_vec_t *v, u32 count)
+{
+    benchDataFill(v, count, sizeof(vecmath_vec_t), 0, NULL);
+}
+
+/* Fill the input planes with the same values as fillVectors() */
+static void fillSoa(vecmath_soa_t *soa)
+{
+    u32 i;
+
+    for (i = 0; i < soa->count; i++) {
+        vecmathSoaPlane(soa, VECMATH_SOA_X)[i] = 1.0f + (float)(i % 97);
+        vecmathSoaPlane(soa, VECMATH_SOA_Y)[i] = 0.5f * (float)(i % 13);
+        vecmathSoaPlane(soa, VECMATH_SOA_Z)[i] = -2.0f + (float)(i % 7);
+        vecmathSoaPlane(soa, VECMATH_SOA_W)[i] = 0.25f * (float)(i % 31);
+    }
+}
+
+/* Vectors/sec of the double-buffered SPU batch kernel vs. chunk size */
+static void benchVecmathBatch(sysSpuImage *image)
+{
+    vecmath_vec_t *v;
+    u64 t0, best;
+    u32 c, r;
+
+    v = (vecmath_vec_t *)memalign(128, BENCH_VECTORS * sizeof(vecmath_vec_t));
+    if (!v) {
+        printf("bench: vecmath batch: out of memory\n");
+        return;
+    }
+
+    fillVectors(v, BENCH_VECTORS);
+    t0 = timerNow();
+    vecmathRefBatch(v, BENCH_VECTORS);
+    printf("bench: vecmath ppu-ref          %10.0f vec/s\n",
+           BENCH_VECTORS / timerToSec(timerNow() - t0));
+
+    /* Thread setup cost alone, to read the batch numbers against */
+    t0 = timerNow();
+    speRunOnce(image, (u64)(uintptr_t)v, 1, 1, 0);
+    printf("bench: vecmath spu setup+1 vec  %10.1f us\n", timerToUsec(timerNow() - t0));
+
+    for (c = 0; c < sizeof(bench_chunks) / sizeof(bench_chunks[0]); c++) {
+        float err;
+        s32 ret = 0;
+
+        best = ~0ULL;
+        for (r = 0; r < BENCH_RUNS; r++) {
+            u64 dt;
+
+            fillVectors(v, BENCH_VECTORS);
+            t0  = timerNow();
+            ret = speRunOnce(image, (u64)(uintptr_t)v, BENCH_VECTORS, bench_chunks[c], 0);
+            dt  = timerNow() - t0;
+            if (dt < best)
+                best = dt;
+        }
+
+        err = vecmathRefMaxError(v, BENCH_VECTORS);
+        printf("bench: vecmath spu chunk=%-4u  %10.0f vec/s  maxerr=%.2e%s\n",
+               bench_chunks[c], BENCH_VECTORS / timerToSec(best), err,
+               ret ? "  (spu error)" : "");
+    }
+
+    free(v);
+}
+
+static int cmpTicks(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* min/avg/p99/max of 'n' submit-to-completion samples (sorts them) */
+static void printLatency(const char *name, u64 *ticks, u32 n)
+{
+    u64 sum = 0;
+    u32 i;
+
+    qsort(ticks, n, sizeof(ticks[0]), cmpTicks);
+    for (i = 0; i < n; i++)
+        sum += ticks[i];
+    printf("bench: latency %-16s min %7.2f  avg %7.2f  p99 %7.2f  max %8.2f us\n", name,
+           timerToUsec(ticks[0]), timerToUsec(sum) / n,
+           timerToUsec(ticks[n * 99 / 100]), timerToUsec(ticks[n - 1]));
+}
+
+/*
+ * Per-job cost of creating, starting and joining a thread for each job;
+ * completion is only known once the group join returns.
+ */
+static void benchDispatchOneshot(sysSpuImage *image)
+{
+    static vecmath_data_t job __attribute__((aligned(128)));
+    static u64 ticks[BENCH_JOBS];
+    u64 t0, total = 0;
+    u32 i;
+
+    job.input[0] = 1.0f;
+    job.input[1] = 2.0f;
+    job.input[2] = 3.0f;
+    job.input[3] = 4.0f;
+
+    for (i = 0; i < BENCH_JOBS; i++) {
+        t0 = timerNow();
+        speRunOnce(image, (u64)(uintptr_t)&job, 0, 0, VECMATH_MODE_ONESHOT);
+        ticks[i] = timerNow() - t0;
+        total   += ticks[i];
+    }
+    printf("bench: dispatch oneshot         %10.1f us/job\n",
+           timerToUsec(total) / BENCH_JOBS);
+    printLatency("group-join", ticks, BENCH_JOBS);
+}
+
+/* Per-job cost of a mailbox submit + event wait on the resident worker */
+static void benchDispatchWorker(spuWorker *worker)
+{
+    static vecmath_data_t job __attribute__((aligned(128)));
+    u64 t0;
+    u32 i;
+
+    if (!worker->running) {
+        printf("bench: dispatch worker: not running\n");
+        return;
+    }
+
+    job.input[0] = 1.0f;
+    job.input[1] = 2.0f;
+    job.input[2] = 3.0f;
+    job.input[3] = 4.0f;
+
+    t0 = timerNow();
+    for (i = 0; i < BENCH_JOBS; i++) {
+        spuWorkerSubmit(worker, 0, VECMATH_KERNEL_SINGLE, &job, 1, 0);
+        spuWorkerWait(worker, 0, 0, NULL);
+    }
+    printf("bench: dispatch worker          %10.1f us/job\n",
+           timerToUsec(timerNow() - t0) / BENCH_JOBS);
+}
+
+/*
+ * Submit-to-completion latency of one SINGLE job on the resident workers
+ * for each completion path: blocking on the event queue, spinning on the
+ * status quadword, polling it between other work, and wait-any over one
+ * job per worker (time to the first and to the last completion).
+ */
+static void benchLatency(spuWorker *worker)
+{
+    static vecmath_data_t job[SPU_WORKER_MAX] __attribute__((aligned(128)));
+    static u64 ticks[BENCH_JOBS], last[BENCH_JOBS];
+    u32 i, j, idx;
+    u64 t0;
+
+    if (!worker->running) {
+        printf("bench: latency: workers not running\n");
+        return;
+    }
+
+    for (j = 0; j < SPU_WORKER_MAX; j++) {
+        job[j].input[0] = 1.0f;
+        job[j].input[1] = 2.0f;
+        job[j].input[2] = 3.0f;
+        job[j].input[3] = 4.0f;
+    }
+
+    spuWorkerSetNotify(worker, SPU_WORKER_NOTIFY_EVENT);
+    for (i = 0; i < BENCH_JOBS; i++) {
+        t0 = timerNow();
+        spuWorkerSubmit(worker, 0, VECMATH_KERNEL_SINGLE, &job[0], 1, 0);
+        spuWorkerWait(worker, 0, 0, NULL);
+        ticks[i] = timerNow() - t0;
+    }
+    printLatency("event-wait", ticks, BENCH_JOBS);
+
+    spuWorkerSetNotify(worker, SPU_WORKER_NOTIFY_STATUS);
+    for (i = 0; i < BENCH_JOBS; i++) {
+        t0 = timerNow();
+        spuWorkerSubmit(worker, 0, VECMATH_KERNEL_SINGLE, &job[0], 1, 0);
+        spuWorkerWait(worker, 0, 0, NULL);
+        ticks[i] = timerNow() - t0;
+    }
+    printLatency("status-wait", ticks, BENCH_JOBS);
+
+    /* A frame loop would check once per iteration of its own work */
+    for (i = 0; i < BENCH_JOBS; i++) {
+        t0 = timerNow();
+        spuWorkerSubmit(worker, 0, VECMATH_KERNEL_SINGLE, &job[0], 1, 0);
+        while (spuWorkerPoll(worker, 0, NULL) == SPU_WORKER_BUSY)
+            ;
+        ticks[i] = timerNow() - t0;
+    }
+    printLatency("status-poll", ticks, BENCH_JOBS);
+
+    for (i = 0; i < BENCH_JOBS; i++) {
+        t0 = timerNow();
+        for (j = 0; j < worker->count; j++)
+            spuWorkerSubmit(worker, j, VECMATH_KERNEL_SINGLE, &job[j], 1, 0);
+        for (j = 0; j < worker->count; j++) {
+            spuWorkerWaitAny(worker, 0, 0, &idx, NULL);
+            if (j == 0)
+                ticks[i] = timerNow() - t0;
+        }
+        last[i] = timerNow() - t0;
+    }
+    printLatency("status-any-first", ticks, BENCH_JOBS);
+    printLatency("status-any-last", last, BENCH_JOBS);
+
+    spuWorkerSetNotify(worker, SPU_WORKER_NOTIFY_EVENT);
+}
+
+/*
+ * Cost of switching SPU kernels on one worker: SOA and empty-frame TILES
+ * jobs back to back (overlay stays resident) against the two alternating
+ * (an overlay load per job), and against one image per kernel, where a
+ * switch means stopping the worker, importing the image and restarting it.
+ */
+static void benchKernelSwitch(sysSpuImage *image)
+{
+    static spudraw_frame_t empty __attribute__((aligned(128)));    /* no tiles */
+    sysSpuImage reload;
+    spuWorker pool;
+    vecmath_soa_t *soa;
+    u64 t0, soa_only, tiles_only, alternate, reloads;
+    u32 i;
+    s32 ret;
+
+    soa = vecmathSoaAlloc(4, VECMATH_SOA_OUT_ALL);
+    if (!soa) {
+        printf("bench: kernel switch: out of memory\n");
+        return;
+    }
+    fillSoa(soa);
+
+    ret = spuWorkerStart(&pool, image, 1);
+    if (ret) {
+        printf("bench: kernel switch: start failed ret=%d\n", ret);
+        vecmathSoaFree(soa);
+        return;
+    }
+
+    t0 = timerNow();
+    for (i = 0; i < BENCH_JOBS; i++)
+        spuWorkerRunSoa(&pool, soa, 0);
+    soa_only = timerNow() - t0;
+
+    t0 = timerNow();
+    for (i = 0; i < BENCH_JOBS; i++) {
+        spuWorkerSubmit(&pool, 0, VECMATH_KERNEL_TILES, &empty, 0, 0);
+        spuWorkerWait(&pool, 0, 0, NULL);
+    }
+    tiles_only = timerNow() - t0;
+
+    t0 = timerNow();
+    for (i = 0; i < BENCH_JOBS; i++) {
+        spuWorkerRunSoa(&pool, soa, 0);
+        spuWorkerSubmit(&pool, 0, VECMATH_KERNEL_TILES, &empty, 0, 0);
+        spuWorkerWait(&pool, 0, 0, NULL);
+    }
+    alternate = timerNow() - t0;
+    spuWorkerStop(&pool);
+
+    reloads = 0;
+    for (i = 0; i < BENCH_RELOADS && ret == 0; i++) {
+        t0  = timerNow();
+        ret = sysSpuImageImport(&reload, spu_bin, 0);
+        if (ret)
+            break;
+        ret = spuWorkerStart(&pool, &reload, 1);
+        if (ret == 0) {
+            spuWorkerRunSoa(&pool, soa, 0);
+            spuWorkerStop(&pool);
+        }
+        sysSpuImageClose(&reload);
+        reloads += timerNow() - t0;
+    }
+
+    printf("bench: kernel same      %8.2f us/job (soa)  %8.2f us/job (tiles)\n",
+           timerToUsec(soa_only) / BENCH_JOBS, timerToUsec(tiles_only) / BENCH_JOBS);
+    printf("bench: kernel overlay   %8.2f us/switch\n",
+           (timerToUsec(alternate) - timerToUsec(soa_only) - timerToUsec(tiles_only)) /
+           (2 * BENCH_JOBS));
+    if (ret == 0)
+        printf("bench: kernel reload    %8.2f us/switch (import + start + job + stop)\n",
+               timerToUsec(reloads) / BENCH_RELOADS);
+    else
+        printf("bench: kernel reload    failed ret=%d\n", ret);
+
+    vecmathSoaFree(soa);
+}
+
+/* Throughput of the shared work queue with 1..6 SPEs on one large batch */
+static void benchQueueScaling(sysSpuImage *image)
+{
+    static vecmath_queue_t queue __attribute__((aligned(128)));
+    spuWorker pool;
+    vecmath_vec_t *v;
+    u32 n;
+
+    v = (vecmath_vec_t *)memalign(128, BENCH_SCALE_VECTORS * sizeof(vecmath_vec_t));
+    if (!v) {
+        printf("bench: queue scaling: out of memory\n");
+        return;
+    }
+
+    for (n = 1; n <= SPU_WORKER_MAX; n++) {
+        u64 t0, dt;
+        s32 done;
+        s32 ret;
+
+        ret = spuWorkerStart(&pool, image, n);
+        if (ret) {
+            printf("bench: queue spes=%u start failed ret=%d\n", n, ret);
+            continue;
+        }
+
+        fillVectors(v, BENCH_SCALE_VECTORS);
+        t0   = timerNow();
+        done = spuWorkerRunQueue(&pool, &queue, v, BENCH_SCALE_VECTORS, 1024, 0);
+        dt   = timerNow() - t0;
+        spuWorkerStop(&pool);
+
+        printf("bench: queue spes=%u  %10.0f vec/s  done=%d  maxerr=%.2e\n",
+               n, BENCH_SCALE_VECTORS / timerToSec(dt), done,
+               vecmathRefMaxError(v, BENCH_SCALE_VECTORS));
+    }
+
+    free(v);
+}
+
+/*
+ * AoS (vecmath_vec_t through the queue kernel) vs. SoA planes on every
+ * worker, for the same batch. Bytes/vec is the DMA traffic in and out.
+ */
+static void benchSoa(spuWorker *worker)
+{
+    static vecmath_queue_t queue __attribute__((aligned(128)));
+    static const u32 flags[] = { VECMATH_SOA_OUT_ALL, VECMATH_SOA_OUT_DOT | VECMATH_SOA_OUT_MAG };
+    vecmath_vec_t *v;
+    u64 t0, dt;
+    s32 done;
+    u32 f;
+
+    if (!worker->running)
+        return;
+
+    v = (vecmath_vec_t *)memalign(128, BENCH_SCALE_VECTORS * sizeof(vecmath_vec_t));
+    if (!v) {
+        printf("bench: soa: out of memory\n");
+        return;
+    }
+
+    fillVectors(v, BENCH_SCALE_VECTORS);
+    t0   = timerNow();
+    done = spuWorkerRunQueue(worker, &queue, v, BENCH_SCALE_VECTORS, 1024, 0);
+    dt   = timerNow() - t0;
+    printf("bench: layout aos      spes=%u  %10.0f vec/s  %3u bytes/vec  done=%d  maxerr=%.2e\n",
+           worker->count, BENCH_SCALE_VECTORS / timerToSec(dt),
+           (u32)(2 * sizeof(vecmath_vec_t)), done, vecmathRefMaxError(v, BENCH_SCALE_VECTORS));
+
+    for (f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        vecmath_soa_t *soa = vecmathSoaAlloc(BENCH_SCALE_VECTORS, flags[f]);
+
+        if (!soa) {
+            printf("bench: soa: out of memory\n");
+            break;
+        }
+
+        /* Same inputs as the AoS run */
+        fillSoa(soa);
+
+        t0   = timerNow();
+        done = spuWorkerRunSoa(worker, soa, 1024);
+        dt   = timerNow() - t0;
+        printf("bench: layout soa-%-4s spes=%u  %10.0f vec/s  %3u bytes/vec  done=%d  maxerr=%.2e\n",
+               flags[f] == VECMATH_SOA_OUT_ALL ? "all" : "dot",
+               worker->count, BENCH_SCALE_VECTORS / timerToSec(dt),
+               vecmathSoaTraffic(soa) / BENCH_SCALE_VECTORS, done, vecmathRefSoaMaxError(soa));
+        vecmathSoaFree(soa);
+    }
+
+    free(v);
+}
+
+/*
+ * Vectors embedded in larger records, on every worker: staging copies on
+ * the PPU around the queue kernel vs. the GATHER kernel's DMA lists, per
+ * record stride (48 = packed) and for shuffled record indices. Times
+ * include the copies.
+ */
+static void benchGather(spuWorker *worker)
+{
+    static vecmath_queue_t  queue  __attribute__((aligned(128)));
+    static vecmath_gather_t gather __attribute__((aligned(128)));
+    u32 n = BENCH_GATHER_VECTORS;
+    vecmath_vec_t *staging;
+    u32 *index;
+    u8 *records;
+    u32 p;
+
+    if (!worker->running)
+        return;
+
+    records = (u8 *)memalign(128, n * BENCH_DATA_STRIDE_MAX);
+    staging = (vecmath_vec_t *)memalign(128, n * sizeof(vecmath_vec_t));
+    index   = (u32 *)memalign(128, VECMATH_GATHER_INDEX_LEN(n) * sizeof(u32));
+    if (!records || !staging || !index) {
+        printf("bench: gather: out of memory\n");
+        goto out;
+    }
+
+    /* A fixed shuffle of the records for the indexed run */
+    benchDataShuffle(index, n, 12345);
+
+    for (p = 0; p < BENCH_DATA_LAYOUTS; p++) {
+        u32 stride, offset;
+        const u32 *idx = benchDataLayout(p, index, &stride, &offset);
+        float err_staged, err_list;
+        u64 t0, staged, list;
+        s32 done_staged, done_list;
+
+        benchDataFill(records, n, stride, offset, idx);
+        t0 = timerNow();
+        vecmathGatherStage(staging, records, n, stride, offset, idx);
+        done_staged = spuWorkerRunQueue(worker, &queue, staging, n, 1024, 0);
+        vecmathGatherUnstage(staging, records, n, stride, offset, idx);
+        staged = timerNow() - t0;
+        err_staged = vecmathRefMaxError(staging, n);
+
+        benchDataFill(records, n, stride, offset, idx);
+        if (vecmathGatherSetup(&gather, records, n, stride, offset, idx, 0) != 0) {
+            printf("bench: gather stride=%u: bad layout\n", stride);
+            continue;
+        }
+        t0 = timerNow();
+        done_list = spuWorkerRunGather(worker, &gather, 1024);
+        list = timerNow() - t0;
+        vecmathGatherStage(staging, records, n, stride, offset, idx);
+        err_list = vecmathRefMaxError(staging, n);
+
+        printf("bench: gather %-7s stride=%-4u spes=%u  staged %10.0f vec/s  dma-list %10.0f vec/s"
+               "  x%.2f  done=%d/%d  maxerr=%.2e/%.2e\n",
+               idx ? "indexed" : "strided", stride, worker->count,
+               n / timerToSec(staged), n / timerToSec(list), (double)staged / (double)list,
+               done_staged, done_list, err_staged, err_list);
+    }
+
+out:
+    free(records);
+    free(staging);
+    free(index);
+}
+
+/*
+ * Vectors/sec and error per precision tier for the ops that use rsqrt
+ * (magnitude, normalize), then throughput of the exact ops. Errors are
+ * in ULPs against the double-precision result.
+ */
+static void benchPrecision(spuWorker *worker)
+{
+    static const struct {
+        const char *name;
+        u32 op, flags, tiered;
+    } ops[] = {
+        { "magnitude", VECMATH_OP_VECMATH,   VECMATH_SOA_OUT_MAG,  1 },
+        { "normalize", VECMATH_OP_NORMALIZE, VECMATH_SOA_OUT_XYZW, 1 },
+        { "dot",       VECMATH_OP_DOT,       VECMATH_SOA_OUT_DOT,  0 },
+        { "cross",     VECMATH_OP_CROSS,     VECMATH_SOA_OUT_XYZW, 0 },
+        { "transform", VECMATH_OP_TRANSFORM, VECMATH_SOA_OUT_XYZW, 0 },
+    };
+    static const char *tiers[] = { "estimate", "newton", "full" };
+    vecmath_soa_t *soa;
+    u32 o, p, i;
+
+    if (!worker->running)
+        return;
+
+    soa = vecmathSoaAlloc(BENCH_SCALE_VECTORS, 0);
+    if (!soa) {
+        printf("bench: precision: out of memory\n");
+        return;
+    }
+    fillSoa(soa);
+    for (i = 0; i < 16; i++)
+        soa->operand[i] = (i % 5 == 0) ? 1.0f : 0.125f * (float)i;
+
+    for (o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+        for (p = 0; p < (ops[o].tiered ? VECMATH_PREC_LEVELS : 1); p++) {
+            u64 t0, dt;
+            s32 done;
+
+            soa->op    = ops[o].op;
+            soa->flags = ops[o].flags;
+            soa->prec  = p;
+
+            t0   = timerNow();
+            done = spuWorkerRunSoa(worker, soa, 1024);
+            dt   = timerNow() - t0;
+
+            if (ops[o].tiered) {
+                double mean;
+                u32 worst = vecmathRefSoaUlp(soa, &mean);
+
+                printf("bench: prec %-9s %-8s %10.0f vec/s  max %6u ulp  mean %8.2f ulp  done=%d\n",
+                       ops[o].name, tiers[p], BENCH_SCALE_VECTORS / timerToSec(dt),
+                       worst, mean, done);
+            } else {
+                printf("bench: prec %-9s %-8s %10.0f vec/s  maxerr=%.2e  done=%d\n",
+                       ops[o].name, "exact", BENCH_SCALE_VECTORS / timerToSec(dt),
+                       vecmathRefSoaMaxError(soa), done);
+            }
+        }
+    }
+
+    vecmathSoaFree(soa);
+}
+
+/*
+ * Draw BENCH_GLYPHS glyphs through 'draw' into an off-screen buffer, laid
+ * out in rows that wrap inside the buffer. Returns elapsed time-base ticks.
+ */
+static u64 timeGlyphs(const glyphTarget *t, u32 scale,
+                      void (*draw)(const glyphTarget *, char, u32, u32, u32, u32))
+{
+    u32 step = FONT_W * scale;
+    u32 x = 0, y = 0, i;
+    u64 t0 = timerNow();
+
+    for (i = 0; i < BENCH_GLYPHS; i++) {
+        draw(t, (char)(FONT_FIRST + i % 95), x, y, 0x00FFFFFF, scale);
+        x += step;
+        if (x + step > t->width) {
+            x = 0;
+            y += step;
+            if (y + step > t->height)
+                y = 0;
+        }
+    }
+    return timerNow() - t0;
+}
+
+/* Glyphs/ms of the per-pixel plotter vs. the atlas blitter */
+static void benchGlyphs(void)
+{
+    glyphTarget t;
+    u32 s;
+
+    t.width  = BENCH_FB_W;
+    t.height = BENCH_FB_H;
+    t.pitch  = BENCH_FB_W * sizeof(u32);
+    t.ptr    = (u32 *)memalign(128, t.pitch * t.height);
+    if (!t.ptr) {
+        printf("bench: glyphs: out of memory\n");
+        return;
+    }
+
+    for (s = 0; s < sizeof(bench_scales) / sizeof(bench_scales[0]); s++) {
+        u32 scale = bench_scales[s];
+        double slow, fast;
+
+        memset(t.ptr, 0, t.pitch * t.height);
+        slow = timerToSec(timeGlyphs(&t, scale, glyphDrawCharPerPixel)) * 1e3;
+        memset(t.ptr, 0, t.pitch * t.height);
+        fast = timerToSec(timeGlyphs(&t, scale, glyphDrawChar)) * 1e3;
+
+        printf("bench: glyphs scale=%u  perpixel %8.1f glyphs/ms  atlas %8.1f glyphs/ms\n",
+               scale, BENCH_GLYPHS / slow, BENCH_GLYPHS / fast);
+    }
+
+    free(t.ptr);
+}
+
+/* MB/s of BENCH_FILLS full-target fills through the current fill path */
+static double fillRate(const glyphTarget *t, u32 color, u32 flags)
+{
+    u64 t0 = timerNow();
+    u32 i;
+
+    for (i = 0; i < BENCH_FILLS; i++)
+        fillRows(t->ptr, t->pitch, t->width, t->height, color, flags);
+    return (double)t->pitch * t->height * BENCH_FILLS / 1e6 / timerToSec(timerNow() - t0);
+}
+
+/*
+ * Fill bandwidth of the scalar and VMX paths at 720p: into an RSX surface
+ * (what the text layer clears) and into main memory, where a zero fill
+ * can also use dcbz.
+ */
+static void benchFill(void)
+{
+    static const char *paths[] = { "scalar", "vmx" };
+    glyphTarget vram, ram;
+    u32 p;
+
+    vram.width  = ram.width  = BENCH_FB_W;
+    vram.height = ram.height = BENCH_FB_H;
+    vram.pitch  = ram.pitch  = BENCH_FB_W * sizeof(u32);
+    vram.ptr = (u32 *)rsxMemalign(64, vram.pitch * vram.height);
+    ram.ptr  = (u32 *)memalign(128, ram.pitch * ram.height);
+    if (!vram.ptr || !ram.ptr) {
+        printf("bench: fill: out of memory\n");
+        if (vram.ptr) rsxFree(vram.ptr);
+        free(ram.ptr);
+        return;
+    }
+
+    for (p = FILL_PATH_SCALAR; p <= FILL_PATH_VECTOR; p++) {
+        fillSetPath(p);
+        printf("bench: fill %-6s  rsx %8.1f MB/s  ram %8.1f MB/s  ram-zero %8.1f MB/s\n",
+               paths[p], fillRate(&vram, 0x00102040, 0), fillRate(&ram, 0x00102040, 0),
+               fillRate(&ram, 0, FILL_CACHED));
+    }
+    fillSetPath(FILL_PATH_VECTOR);
+
+    rsxFree(vram.ptr);
+    free(ram.ptr);
+}
+
+/*
+ * Frame time of the PPU and RSX back ends, full and dirty redraw, at
+ * 720p and 1080p. Frames go to an off-screen RSX surface and each one
+ * waits for the RSX (rsxFinish), so the time covers the GPU work too.
+ */
+static void benchBackends(gcmContextData *context, int spu_ok)
+{
+    static const u32 sizes[][2] = { { 1280, 720 }, { 1920, 1080 } };
+    static const textBackend *backends[] = {
+        &textBackendSoftware, &textBackendRsx, &textBackendSpu
+    };
+    u32 nbackends = spu_ok ? 3 : 2;
+    static textLayer l;
+    u32 z, b, m, f;
+
+    for (z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++) {
+        glyphTarget t;
+
+        t.width  = sizes[z][0];
+        t.height = sizes[z][1];
+        t.pitch  = t.width * sizeof(u32);
+        t.ptr    = (u32 *)rsxMemalign(64, t.pitch * t.height);
+        if (!t.ptr) {
+            printf("bench: backends %ux%u: out of RSX memory\n", t.width, t.height);
+            continue;
+        }
+        rsxAddressToOffset(t.ptr, &t.offset);
+
+        for (b = 0; b < nbackends; b++) {
+            for (m = 0; m < 2; m++) {
+                u64 t0;
+
+                textLayerInit(&l, m ? TEXT_REDRAW_DIRTY : TEXT_REDRAW_FULL);
+                textLayerSetBackend(&l, backends[b]);
+
+                t0 = timerNow();
+                for (f = 0; f < BENCH_FRAMES; f++) {
+                    headlessScene(&l, f, t.width, t.height);
+                    textLayerEnd(&l, &t, 0);
+                    rsxFinish(context, f + 1);
+                }
+                printf("bench: frame %ux%u %s %-5s  %8.3f ms/frame\n",
+                       t.width, t.height, backends[b]->name, m ? "dirty" : "full",
+                       timerToSec(timerNow() - t0) * 1e3 / BENCH_FRAMES);
+
+                if (backends[b] == &textBackendSpu) {
+                    const spuDrawStats *ts = spuDrawGetStats();
+                    printf("bench: tiles %ux%u %-5s  %u/%u drawn  min %.1f avg %.1f max %.1f us/tile\n",
+                           t.width, t.height, m ? "dirty" : "full",
+                           ts->tiles_drawn, ts->tiles, timerToUsec(ts->ticks_min),
+                           timerToUsec(ts->ticks_avg), timerToUsec(ts->ticks_max));
+                }
+            }
+        }
+        rsxFree(t.ptr);
+    }
+}
+
+void runBenchmarks(sysSpuImage *image, spuWorker *worker, gcmContextData *context)
+{
+    u32 nworkers = worker->running ? worker->count : 0;
+
+    printf("bench: begin\n");
+    benchFill();
+    benchGlyphs();
+
+    /* One-shot groups and the scaling sweep need the SPEs the workers hold */
+    spuWorkerStop(worker);
+    benchVecmathBatch(image);
+    benchDispatchOneshot(image);
+    benchKernelSwitch(image);
+    benchQueueScaling(image);
+
+    if (nworkers)
+        spuWorkerStart(worker, image, nworkers);
+    benchDispatchWorker(worker);
+    benchLatency(worker);
+    benchSoa(worker);
+    benchGather(worker);
+    benchPrecision(worker);
+    benchBackends(context, worker->running && spuDrawInit(worker) == 0);
+    printf("bench: end\n");
+}
@@ -0,0 +1,15 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+/*
+ * Startup benchmarks, compiled in with `make BENCH=1`.
+ * Results are printed to stdout (lv2 TTY).
+ */
+#include <sys/spu.h>
+#include <rsx/rsx.h>
+
+#include "spu_worker.h"
+
+void runBenchmarks(sysSpuImage *image, spuWorker *worker, gcmContextData *context);
+
+#endif
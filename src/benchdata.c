@@ -0,0 +1,52 @@
+/*
+ * Benchmark inputs (see benchdata.h).
+ */
+
+#include <string.h>
+
+#include "benchdata.h"
+#include "vecmath.h"
+
+void benchDataFill(void *base, u32 count, u32 stride, u32 offset, const u32 *index)
+{
+    u32 i;
+
+    for (i = 0; i < count; i++) {
+        vecmath_vec_t *v = (vecmath_vec_t *)((u8 *)base + (index ? index[i] : i) * stride +
+                                             offset);
+
+        memset(v, 0, sizeof(*v));
+        v->input[0] = 1.0f + (float)(i % 97);
+        v->input[1] = 0.5f * (float)(i % 13);
+        v->input[2] = -2.0f + (float)(i % 7);
+        v->input[3] = 0.25f * (float)(i % 31);
+    }
+}
+
+void benchDataShuffle(u32 *index, u32 count, u32 seed)
+{
+    u32 i;
+
+    for (i = 0; i < ((count + 3) & ~3u); i++)
+        index[i] = i < count ? i : 0;
+    for (i = count - 1; count && i > 0; i--) {
+        u32 j, t;
+
+        seed = seed * 1664525u + 1013904223u;
+        j = (seed >> 8) % (i + 1);
+        t = index[i]; index[i] = index[j]; index[j] = t;
+    }
+}
+
+const u32 *benchDataLayout(u32 layout, const u32 *index, u32 *stride, u32 *offset)
+{
+    static const u32 strides[BENCH_DATA_LAYOUTS - 1] = {
+        48, 64, 128, 256, 512, BENCH_DATA_STRIDE_MAX
+    };
+    /* The last layout reuses the 128-byte records through the shuffle */
+    const u32 *idx = layout < BENCH_DATA_LAYOUTS - 1 ? NULL : index;
+
+    *stride = idx ? 128 : strides[layout];
+    *offset = *stride > sizeof(vecmath_vec_t) ? 16 : 0;
+    return idx;
+}
@@ -0,0 +1,35 @@
+#ifndef __BENCHDATA_H__
+#define __BENCHDATA_H__
+
+/*
+ * Inputs shared by the startup benchmarks (bench.c, BENCH=1) and the host
+ * tools: the vector input pattern, a fixed shuffle and the record layouts
+ * the embedded-vector runs go through. Not linked into the plain demo.
+ */
+#include <ppu-types.h>
+
+#define BENCH_DATA_LAYOUTS      7       /* every stride, then shuffled */
+#define BENCH_DATA_STRIDE_MAX   1024    /* largest record, bytes */
+
+/*
+ * Vector i of 'count', at base + r * stride + offset with r = i or
+ * index[i], gets the input pattern; the rest of its vecmath_vec_t is
+ * zeroed and the record bytes around it are left alone. A plain array
+ * is stride sizeof(vecmath_vec_t), offset 0, no index.
+ */
+void benchDataFill(void *base, u32 count, u32 stride, u32 offset, const u32 *index);
+
+/*
+ * A fixed permutation of 0..count-1 for 'seed' (Fisher-Yates on an LCG).
+ * Fills ((count + 3) & ~3) entries; the padding gets record 0.
+ */
+void benchDataShuffle(u32 *index, u32 count, u32 seed);
+
+/*
+ * Record layout 'layout' (0..BENCH_DATA_LAYOUTS-1): 48 (packed) to
+ * BENCH_DATA_STRIDE_MAX bytes in order, then 128-byte records through
+ * 'index'. Returns the index to use (NULL = in order).
+ */
+const u32 *benchDataLayout(u32 layout, const u32 *index, u32 *stride, u32 *offset);
+
+#endif
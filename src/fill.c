@@ -0,0 +1,111 @@
+/*
+ * Scalar and VMX pixel fills (see fill.h).
+ */
+
+#include "fill.h"
+
+#ifdef __powerpc__
+#include <ppu_intrinsics.h>
+#endif
+
+#ifdef __ALTIVEC__
+#include <altivec.h>
+typedef vector unsigned int fillVec;
+#define FILL_STORE(v, off, p)   vec_st(v, off, p)
+#else
+/* Host build: GCC generic vectors, lowered to whatever SIMD it has */
+typedef u32 fillVec __attribute__((vector_size(16)));
+#define FILL_STORE(v, off, p)   (*(fillVec *)((u8 *)(p) + (off)) = (v))
+#endif
+
+#define FILL_LINE   128     /* PPU cache line, the dcbz granule */
+
+static u32 path = FILL_PATH_VECTOR;
+
+void fillSetPath(u32 p)
+{
+    path = p;
+}
+
+u32 fillGetPath(void)
+{
+    return path;
+}
+
+static void spanScalar(u32 *dst, u32 n, u32 color)
+{
+    u32 i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = color;
+}
+
+static void spanVector(u32 *dst, u32 n, u32 color)
+{
+    fillVec v = { color, color, color, color };
+
+    while (n && ((uintptr_t)dst & 15)) {
+        *dst++ = color;
+        n--;
+    }
+    for (; n >= 16; n -= 16, dst += 16) {
+        FILL_STORE(v, 0, dst);
+        FILL_STORE(v, 16, dst);
+        FILL_STORE(v, 32, dst);
+        FILL_STORE(v, 48, dst);
+    }
+    for (; n >= 4; n -= 4, dst += 4)
+        FILL_STORE(v, 0, dst);
+    while (n--)
+        *dst++ = color;
+}
+
+/*
+ * Zero a span a cache line at a time: dcbz establishes the line in the
+ * cache already zeroed, without first reading it from memory.
+ */
+static void spanZeroLines(u32 *dst, u32 n)
+{
+#ifdef __powerpc__
+    u32 head = (u32)(((FILL_LINE - ((uintptr_t)dst & (FILL_LINE - 1))) & (FILL_LINE - 1)) / 4);
+
+    if (head > n)
+        head = n;
+    spanVector(dst, head, 0);
+    dst += head;
+    n   -= head;
+
+    for (; n >= FILL_LINE / 4; n -= FILL_LINE / 4, dst += FILL_LINE / 4)
+        __dcbz(dst);
+#endif
+    spanVector(dst, n, 0);
+}
+
+void fillSpan(u32 *dst, u32 n, u32 color)
+{
+    if (path == FILL_PATH_SCALAR)
+        spanScalar(dst, n, color);
+    else
+        spanVector(dst, n, color);
+}
+
+void fillRows(u32 *dst, u32 pitch, u32 w, u32 h, u32 color, u32 flags)
+{
+    u32 stride = pitch / 4;
+    u32 y;
+
+    /* Rows back to back (full-width clears): one long span */
+    if (w == stride) {
+        w *= h;
+        h  = 1;
+    }
+
+    for (y = 0; y < h; y++, dst += stride) {
+        if (path == FILL_PATH_SCALAR)
+            spanScalar(dst, w, color);
+        else if (color == 0 && (flags & FILL_CACHED))
+            spanZeroLines(dst, w);
+        else
+            spanVector(dst, w, color);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef __FILL_H__
+#define __FILL_H__
+
+/*
+ * Pixel fill primitives behind every software drawing path (glyph runs,
+ * text layer clears).
+ *
+ * The vector path writes single pixels up to the first 16-byte boundary,
+ * then 16 bytes per vec_st (64 per loop iteration), then single pixels
+ * again for the tail. The scalar path is the original one-store-per-pixel
+ * loop, kept selectable at run time for A/B measurements.
+ */
+#include <ppu-types.h>
+
+#define FILL_PATH_SCALAR    0
+#define FILL_PATH_VECTOR    1   /* default */
+
+/*
+ * fillRows flag: the target is cacheable main memory, so zero fills may
+ * clear whole 128-byte lines with dcbz. Never set it for RSX-mapped
+ * framebuffers: they are cache-inhibited and dcbz there raises an
+ * alignment exception.
+ */
+#define FILL_CACHED         0x1
+
+void fillSetPath(u32 path);
+u32  fillGetPath(void);
+
+/* Store 'color' into dst[0..n) */
+void fillSpan(u32 *dst, u32 n, u32 color);
+
+/* Fill a w x h rectangle whose rows are 'pitch' bytes apart */
+void fillRows(u32 *dst, u32 pitch, u32 w, u32 h, u32 color, u32 flags);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * Glyph atlas: per-scale run tables, written out as fill spans.
+ */
+
+#include "fill.h"
+#include "glyph.h"
+
+#define GLYPH_COUNT     (FONT_LAST - FONT_FIRST + 1)
+#define GLYPH_MAX_RUNS  4   /* an 8-bit row has at most 4 runs of set bits */
+
+/* Runs of lit pixels in one glyph row, already multiplied by the scale */
+typedef struct {
+    u8 count;
+    u8 x[GLYPH_MAX_RUNS];
+    u8 w[GLYPH_MAX_RUNS];
+} glyphRow;
+
+static glyphRow rows[GLYPH_MAX_SCALE][GLYPH_COUNT][FONT_H];
+static u8       rows_built[GLYPH_MAX_SCALE];
+
+static u32 glyphIndex(char c)
+{
+    if (c < FONT_FIRST || c > FONT_LAST)
+        c = '?';
+    return (u32)(c - FONT_FIRST);
+}
+
+/* Expand every glyph row of the font into runs for one scale */
+static void buildRows(u32 scale)
+{
+    u32 g, r;
+
+    for (g = 0; g < GLYPH_COUNT; g++) {
+        for (r = 0; r < FONT_H; r++) {
+            glyphRow *row = &rows[scale - 1][g][r];
+            u8 bits = font8x8[g][r];
+            u32 col = 0;
+
+            row->count = 0;
+            while (col < FONT_W) {
+                u32 start;
+
+                if (!(bits & (0x80 >> col))) {
+                    col++;
+                    continue;
+                }
+                start = col;
+                while (col < FONT_W && (bits & (0x80 >> col)))
+                    col++;
+
+                row->x[row->count] = (u8)(start * scale);
+                row->w[row->count] = (u8)((col - start) * scale);
+                row->count++;
+            }
+        }
+    }
+    rows_built[scale - 1] = 1;
+}
+
+/* Blit one glyph whose runs are already resolved */
+static void blitGlyph(const glyphTarget *t, const glyphRow *grows, u32 color,
+                      u32 px, u32 py, u32 scale)
+{
+    u32 stride = t->pitch / 4;
+    u32 size   = FONT_W * scale;
+    u32 cw, ch, r, sy, i;
+    u32 *dst;
+
+    /* Clip once per glyph */
+    if (px >= t->width || py >= t->height)
+        return;
+    cw = t->width  - px < size ? t->width  - px : size;
+    ch = t->height - py < size ? t->height - py : size;
+
+    dst = t->ptr + py * stride + px;
+
+    if (cw == size && ch == size) {
+        for (r = 0; r < FONT_H; r++) {
+            const glyphRow *row = &grows[r];
+            for (sy = 0; sy < scale; sy++, dst += stride) {
+                for (i = 0; i < row->count; i++)
+                    fillSpan(dst + row->x[i], row->w[i], color);
+            }
+        }
+        return;
+    }
+
+    /* Partially visible: trim runs against the clipped width */
+    for (r = 0; r < FONT_H && r * scale < ch; r++) {
+        const glyphRow *row = &grows[r];
+        for (sy = 0; sy < scale && r * scale + sy < ch; sy++, dst += stride) {
+            for (i = 0; i < row->count; i++) {
+                u32 x = row->x[i];
+                u32 w = row->w[i];
+
+                if (x >= cw)
+                    break;
+                if (x + w > cw)
+                    w = cw - x;
+                fillSpan(dst + x, w, color);
+            }
+        }
+    }
+}
+
+void glyphDrawChar(const glyphTarget *t, char c, u32 px, u32 py,
+                   u32 color, u32 scale)
+{
+    if (scale < 1 || scale > GLYPH_MAX_SCALE) {
+        glyphDrawCharPerPixel(t, c, px, py, color, scale);
+        return;
+    }
+    if (!rows_built[scale - 1])
+        buildRows(scale);
+
+    blitGlyph(t, rows[scale - 1][glyphIndex(c)], color, px, py, scale);
+}
+
+void glyphDrawString(const glyphTarget *t, const char *str, u32 x, u32 y,
+                     u32 color, u32 scale)
+{
+    u32 cx = x;
+
+    if (scale < 1 || scale > GLYPH_MAX_SCALE) {
+        for (; *str; str++) {
+            if (*str == '\n') {
+                cx = x;
+                y += FONT_H * scale + 2;
+            } else {
+                glyphDrawCharPerPixel(t, *str, cx, y, color, scale);
+                cx += FONT_W * scale;
+            }
+        }
+        return;
+    }
+
+    /* Resolve the atlas entries once per string, not once per glyph */
+    if (!rows_built[scale - 1])
+        buildRows(scale);
+
+    for (; *str; str++) {
+        if (*str == '\n') {
+            cx = x;
+            y += FONT_H * scale + 2;
+        } else {
+            blitGlyph(t, rows[scale - 1][glyphIndex(*str)], color, cx, y, scale);
+            cx += FONT_W * scale;
+        }
+    }
+}
+
+void glyphDrawCharPerPixel(const glyphTarget *t, char c, u32 px, u32 py,
+                           u32 fg, u32 scale)
+{
+    const u8 *glyph = font8x8[glyphIndex(c)];
+    u32 row, col, sy, sx;
+
+    for (row = 0; row < FONT_H; row++) {
+        u8 bits = glyph[row];
+        for (col = 0; col < FONT_W; col++) {
+            if (bits & (0x80 >> col)) {
+                /* scale the pixel */
+                for (sy = 0; sy < scale; sy++) {
+                    for (sx = 0; sx < scale; sx++) {
+                        u32 x = px + col * scale + sx;
+                        u32 y = py + row * scale + sy;
+                        if (x < t->width && y < t->height)
+                            t->ptr[y * (t->pitch / 4) + x] = fg;
+                    }
+                }
+            }
+        }
+    }
+}
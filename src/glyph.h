@@ -0,0 +1,41 @@
+#ifndef __GLYPH_H__
+#define __GLYPH_H__
+
+/*
+ * Glyph atlas blitter for the 8x8 bitmap font.
+ *
+ * Each glyph row is pre-expanded once per scale into horizontal runs of
+ * lit pixels. Drawing a glyph is then a handful of fillSpan() calls per
+ * output row (see fill.h), with clipping decided once per glyph.
+ */
+#include <ppu-types.h>
+
+#include "font8x8.h"
+
+#define GLYPH_MAX_SCALE     8   /* larger scales fall back to per-pixel */
+
+/* Pixel target: 'pitch' is in bytes, like displayBuffer */
+typedef struct {
+    u32 *ptr;
+    u32  width;
+    u32  height;
+    u32  pitch;
+    u32  offset;    /* RSX offset of ptr, used by the hardware back end */
+} glyphTarget;
+
+/* Draw a string through the atlas. '\n' starts a new line. */
+void glyphDrawString(const glyphTarget *t, const char *str, u32 x, u32 y,
+                     u32 color, u32 scale);
+
+/* Draw one glyph through the atlas */
+void glyphDrawChar(const glyphTarget *t, char c, u32 px, u32 py,
+                   u32 color, u32 scale);
+
+/*
+ * Original per-pixel plotter (bit test + scale x scale loop + bounds check
+ * per output pixel). Kept as the benchmark baseline.
+ */
+void glyphDrawCharPerPixel(const glyphTarget *t, char c, u32 px, u32 py,
+                           u32 color, u32 scale);
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * Headless offscreen rendering and frame dumps (see headless.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "headless.h"
+#include "timer.h"
+
+#define HEADLESS_BG     0x00102040
+
+/* FNV-1a over 32-bit words, as hostbench */
+static u32 checksum(const glyphTarget *t)
+{
+    u32 h = 2166136261u;
+    u32 x, y;
+
+    for (y = 0; y < t->height; y++) {
+        const u32 *row = (const u32 *)((u8 *)t->ptr + y * t->pitch);
+
+        for (x = 0; x < t->width; x++)
+            h = (h ^ row[x]) * 16777619u;
+    }
+    return h;
+}
+
+void headlessScene(textLayer *l, u32 frame, u32 width, u32 height)
+{
+    char buf[112];
+
+    textLayerBegin(l, HEADLESS_BG);
+    textLayerAdd(l, "Hola Mundo PS3!", 80, 60, 0x00FFFFFF, 4);
+    textLayerAdd(l, "RSX framebuffer + bitmap font demo", 80, 130, 0x0000CC00, 2);
+    textLayerAdd(l, "Press X to exit, [] redraw mode, /\\ back end,", 80, 180, 0x00CCCCCC, 2);
+    textLayerAdd(l, "O profiler, R1 buffers, L1 VMX/scalar fills", 80, 205, 0x00CCCCCC, 2);
+    sprintf(buf, "Frame: %u  input->flip %.1f ms (avg %.1f, max %.1f)", frame, 0.0, 0.0, 0.0);
+    textLayerAdd(l, buf, 80, 240, 0x00AAAAAA, 2);
+    sprintf(buf, "Resolution: %ux%u  startup: frame %.1f ms, SPE %.1f ms",
+            width, height, 0.0, 0.0);
+    textLayerAdd(l, buf, 80, 280, 0x00AAAAAA, 2);
+
+    /* The first SPE job's input and results */
+    textLayerAdd(l, "--- SPE Vector Math ---", 80, 340, 0x00FFD700, 2);
+    textLayerAdd(l, "Input:  (1.0, 2.0, 3.0, 4.0)", 80, 370, 0x0099CCFF, 2);
+    textLayerAdd(l, "Output: (1.0, 4.0, 9.0, 16.0)", 80, 400, 0x0099CCFF, 2);
+    textLayerAdd(l, "Dot product: 30.00", 80, 430, 0x0099CCFF, 2);
+    textLayerAdd(l, "Magnitude:   5.48", 80, 460, 0x0099CCFF, 2);
+
+    /* Status lines with fixed values, so every mode and path draws the same pixels */
+    textLayerAdd(l, "Redraw: dirty/ppu/vmx  written 0 KB (0 rects, 0 strings)",
+                 80, 500, 0x00AAAAAA, 2);
+    textLayerAdd(l, "Swap: 2 buffers  missed vsyncs 0 (0 total)  PPU idle 0.0%",
+                 80, 560, 0x00AAAAAA, 2);
+    textLayerAdd(l, "SPU pipe: latency 1 frames (avg 1.00, max 1)  hidden 100%  stalls 0",
+                 80, 590, 0x00AAAAAA, 2);
+    sprintf(buf, "  frame %u: %u vectors, v[0] dot %.3f mag %.3f",
+            frame ? frame - 1 : 0, 1024, 0.0, 0.0);
+    textLayerAdd(l, buf, 80, 620, 0x0099CCFF, 2);
+}
+
+s32 headlessWritePpm(const glyphTarget *t, const char *path)
+{
+    FILE *f;
+    u8 *line;
+    u32 x, y;
+    s32 ret = 0;
+
+    if (!(f = fopen(path, "wb")))
+        return -1;
+    if (!(line = (u8 *)malloc(t->width * 3))) {
+        fclose(f);
+        return -1;
+    }
+
+    fprintf(f, "P6\n%u %u\n255\n", t->width, t->height);
+    for (y = 0; y < t->height && !ret; y++) {
+        const u32 *row = (const u32 *)((u8 *)t->ptr + y * t->pitch);
+
+        for (x = 0; x < t->width; x++) {
+            line[x * 3 + 0] = (u8)(row[x] >> 16);
+            line[x * 3 + 1] = (u8)(row[x] >> 8);
+            line[x * 3 + 2] = (u8)row[x];
+        }
+        if (fwrite(line, 3, t->width, f) != t->width)
+            ret = -1;
+    }
+
+    free(line);
+    if (fclose(f) != 0)
+        ret = -1;
+    return ret;
+}
+
+s32 headlessWriteRaw(const glyphTarget *t, const char *path)
+{
+    FILE *f;
+    u32 y;
+    s32 ret = 0;
+
+    if (!(f = fopen(path, "wb")))
+        return -1;
+    for (y = 0; y < t->height && !ret; y++)
+        if (fwrite((u8 *)t->ptr + y * t->pitch, sizeof(u32), t->width, f) != t->width)
+            ret = -1;
+    if (fclose(f) != 0)
+        ret = -1;
+    return ret;
+}
+
+s32 headlessComparePpm(const glyphTarget *t, const char *path, u32 *first)
+{
+    FILE *f;
+    u8 *line;
+    u32 w, h, max, x, y;
+    s32 diff = 0;
+
+    if (!(f = fopen(path, "rb")))
+        return -1;
+    /* Our own header: no comments, one whitespace byte before the data */
+    if (fscanf(f, "P6 %u %u %u", &w, &h, &max) != 3 || fgetc(f) == EOF ||
+        w != t->width || h != t->height || max != 255 ||
+        !(line = (u8 *)malloc(w * 3))) {
+        fclose(f);
+        return -1;
+    }
+
+    for (y = 0; y < h; y++) {
+        const u32 *row = (const u32 *)((u8 *)t->ptr + y * t->pitch);
+
+        if (fread(line, 3, w, f) != w) {
+            diff = -1;
+            break;
+        }
+        for (x = 0; x < w; x++) {
+            u32 want = (line[x * 3] << 16) | (line[x * 3 + 1] << 8) | line[x * 3 + 2];
+
+            if ((row[x] & 0x00ffffff) != want) {
+                if (!diff && first)
+                    *first = y * w + x;
+                diff++;
+            }
+        }
+    }
+
+    free(line);
+    fclose(f);
+    return diff;
+}
+
+/* Write and/or compare the buffer frame 'n' was just drawn into */
+static void checkFrame(const headlessConfig *c, headlessResult *r,
+                       const glyphTarget *t, u32 n)
+{
+    char path[256];
+    u32 first = 0;
+    s32 diff;
+
+    if (c->dump_dir) {
+        snprintf(path, sizeof(path), "%s/frame_%05u.%s", c->dump_dir, n,
+                 c->raw ? "raw" : "ppm");
+        if ((c->raw ? headlessWriteRaw(t, path) : headlessWritePpm(t, path)) == 0)
+            r->dumped++;
+        else
+            fprintf(stderr, "headless: can't write %s\n", path);
+    }
+
+    if (c->golden_dir) {
+        snprintf(path, sizeof(path), "%s/frame_%05u.ppm", c->golden_dir, n);
+        diff = headlessComparePpm(t, path, &first);
+        r->compared++;
+        if (diff < 0) {
+            r->mismatched++;
+            fprintf(stderr, "headless: frame %u: no usable golden %s\n", n, path);
+        } else if (diff > 0) {
+            r->mismatched++;
+            fprintf(stderr, "headless: frame %u: %d pixels differ from %s (first at %u,%u)\n",
+                    n, diff, path, first % t->width, first / t->width);
+        }
+    }
+}
+
+s32 headlessRun(const headlessConfig *c, headlessResult *r)
+{
+    static textLayer layer;
+    glyphTarget bufs[TEXT_MAX_BUFFERS];
+    u32 count = c->buffers, next = 0, f, b;
+    s32 ret = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (count < 1)
+        count = 1;
+    if (count > TEXT_MAX_BUFFERS)
+        count = TEXT_MAX_BUFFERS;
+
+    memset(bufs, 0, sizeof(bufs));
+    for (b = 0; b < count; b++) {
+        bufs[b].width  = c->width;
+        bufs[b].height = c->height;
+        bufs[b].pitch  = c->width * sizeof(u32);
+        bufs[b].ptr    = (u32 *)memalign(128, bufs[b].pitch * c->height);
+        if (!bufs[b].ptr) {
+            ret = -1;
+            goto out;
+        }
+    }
+
+    textLayerInit(&layer, c->mode);
+    for (f = 0; f < c->frames; f++) {
+        u64 t0 = timerNow();
+
+        headlessScene(&layer, f, c->width, c->height);
+        textLayerEnd(&layer, &bufs[f % count], f % count);
+        r->ticks += timerNow() - t0;
+
+        /* 'dump' is sorted, so one cursor walks it */
+        while (next < c->dump_count && c->dump[next] < f)
+            next++;
+        if (next < c->dump_count && c->dump[next] == f)
+            checkFrame(c, r, &bufs[f % count], f);
+    }
+
+    r->frames = c->frames;
+    r->fps = r->ticks ? c->frames / timerToSec(r->ticks) : 0.0;
+    if (c->frames)
+        r->checksum = checksum(&bufs[(c->frames - 1) % count]);
+
+out:
+    for (b = 0; b < count; b++)
+        free(bufs[b].ptr);
+    return ret;
+}
@@ -0,0 +1,64 @@
+#ifndef __HEADLESS_H__
+#define __HEADLESS_H__
+
+/*
+ * Headless offscreen rendering. The demo's text frame is drawn through
+ * the text layer into ordinary memory buffers, rotated like the
+ * swapchain, with no video configuration and no flip, as fast as the
+ * renderer allows. Chosen frames can be written out as PPM or raw
+ * XRGB, and compared pixel for pixel against golden PPMs.
+ *
+ * Only the render is timed; dumps and compares are not part of fps.
+ */
+#include <ppu-types.h>
+
+#include "glyph.h"
+#include "textlayer.h"
+
+typedef struct {
+    u32            width;
+    u32            height;
+    u32            frames;         /* frames to render */
+    u32            buffers;        /* 1..TEXT_MAX_BUFFERS in rotation */
+    textRedrawMode mode;
+    const u32     *dump;           /* frame numbers to write and compare */
+    u32            dump_count;
+    const char    *dump_dir;       /* NULL: don't write frames */
+    const char    *golden_dir;     /* NULL: don't compare */
+    u32            raw;            /* dump raw XRGB words instead of PPM */
+} headlessConfig;
+
+typedef struct {
+    u32    frames;
+    u64    ticks;          /* time spent rendering */
+    double fps;
+    u32    dumped;
+    u32    compared;
+    u32    mismatched;     /* compared frames that differ or are missing */
+    u32    checksum;       /* FNV-1a of the last frame */
+} headlessResult;
+
+/*
+ * Declare the demo frame 'frame' into 'l': the main loop's layout, with
+ * fixed values in place of the live timings, SPE results and counters.
+ * Deterministic: the same frame number and size always declare the same
+ * strings. This is the one demo scene; the startup benchmarks draw it too.
+ */
+void headlessScene(textLayer *l, u32 frame, u32 width, u32 height);
+
+/* Run 'c' to completion. Returns 0, or -1 if a buffer can't be allocated. */
+s32 headlessRun(const headlessConfig *c, headlessResult *r);
+
+/* Binary PPM (P6, maxval 255) / raw XRGB words in memory order */
+s32 headlessWritePpm(const glyphTarget *t, const char *path);
+s32 headlessWriteRaw(const glyphTarget *t, const char *path);
+
+/*
+ * Compare 't' with a P6 file as written by headlessWritePpm(). Returns
+ * the number of differing pixels (0 if identical), or -1 if the file is
+ * missing, unreadable or a different size. '*first' gets the first
+ * difference as y * width + x.
+ */
+s32 headlessComparePpm(const glyphTarget *t, const char *path, u32 *first);
+
+#endif
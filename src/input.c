@@ -0,0 +1,206 @@
+/*
+ * Pad polling thread and SPSC event ring (see input.h).
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <io/pad.h>
+#include <sys/thread.h>
+
+#include "input.h"
+#include "timer.h"
+
+#define INPUT_THREAD_PRIO   500     /* ahead of the main thread (1000) */
+#define INPUT_THREAD_STACK  16384
+
+/*
+ * The ring: the thread only writes 'head' and the main loop only writes
+ * 'tail', each on its own cache line so neither side's store invalidates
+ * the line the other one spins on.
+ */
+static struct {
+    volatile u32 head __attribute__((aligned(128)));
+    volatile u32 tail __attribute__((aligned(128)));
+    inputEvent   ev[INPUT_RING_SIZE] __attribute__((aligned(128)));
+} ring;
+
+static sys_ppu_thread_t thread;
+static volatile u32     running;
+static u32              period_us;
+static inputStats       stats;
+static volatile u32     dropped;
+
+/* Presses drained but not yet flipped: count, oldest and summed timestamps */
+static u32 unflipped;
+static u64 unflipped_oldest;
+static u64 unflipped_sum;
+static double latency_sum;
+
+static u32 padButtons(const padData *d)
+{
+    u32 b = 0;
+
+    if (d->BTN_LEFT)     b |= INPUT_LEFT;
+    if (d->BTN_DOWN)     b |= INPUT_DOWN;
+    if (d->BTN_RIGHT)    b |= INPUT_RIGHT;
+    if (d->BTN_UP)       b |= INPUT_UP;
+    if (d->BTN_START)    b |= INPUT_START;
+    if (d->BTN_R3)       b |= INPUT_R3;
+    if (d->BTN_L3)       b |= INPUT_L3;
+    if (d->BTN_SELECT)   b |= INPUT_SELECT;
+    if (d->BTN_SQUARE)   b |= INPUT_SQUARE;
+    if (d->BTN_CROSS)    b |= INPUT_CROSS;
+    if (d->BTN_CIRCLE)   b |= INPUT_CIRCLE;
+    if (d->BTN_TRIANGLE) b |= INPUT_TRIANGLE;
+    if (d->BTN_R1)       b |= INPUT_R1;
+    if (d->BTN_L1)       b |= INPUT_L1;
+    if (d->BTN_R2)       b |= INPUT_R2;
+    if (d->BTN_L2)       b |= INPUT_L2;
+    return b;
+}
+
+/* Producer side: drop the event if the main loop has fallen a ring behind */
+static void push(const inputEvent *ev)
+{
+    u32 head = ring.head;
+
+    if (head - ring.tail >= INPUT_RING_SIZE) {
+        dropped++;
+        return;
+    }
+    ring.ev[head & (INPUT_RING_SIZE - 1)] = *ev;
+
+    /* The event must be visible before the index that publishes it */
+    __lwsync();
+    ring.head = head + 1;
+}
+
+static void inputThread(void *arg)
+{
+    u32 state[INPUT_PADS];
+    padInfo info;
+    padData data;
+    u32 p;
+
+    (void)arg;
+    memset(state, 0, sizeof(state));
+
+    while (running) {
+        ioPadGetInfo(&info);
+        for (p = 0; p < INPUT_PADS; p++) {
+            inputEvent ev;
+            u32 now;
+
+            if (!info.status[p]) {
+                /* Unplugged: release whatever it was holding */
+                now = 0;
+            } else {
+                /* len 0: nothing changed since the last read */
+                ioPadGetData(p, &data);
+                if (data.len == 0)
+                    continue;
+                now = padButtons(&data);
+            }
+            if (now == state[p])
+                continue;
+
+            ev.time     = timerNow();
+            ev.pad      = p;
+            ev.pressed  = now & ~state[p];
+            ev.released = state[p] & ~now;
+            ev.buttons  = now;
+            state[p]    = now;
+            push(&ev);
+        }
+        usleep(period_us);
+    }
+    sysThreadExit(0);
+}
+
+s32 inputStart(u32 rate_hz)
+{
+    s32 ret;
+
+    memset(&stats, 0, sizeof(stats));
+    ring.head = ring.tail = 0;
+    dropped = 0;
+    unflipped = 0;
+    unflipped_sum = 0;
+    latency_sum = 0.0;
+    period_us = 1000000 / (rate_hz ? rate_hz : 1);
+
+    ret = ioPadInit(INPUT_PADS);
+    if (ret)
+        return ret;
+
+    running = 1;
+    ret = sysThreadCreate(&thread, inputThread, NULL, INPUT_THREAD_PRIO,
+                          INPUT_THREAD_STACK, THREAD_JOINABLE, "input");
+    if (ret) {
+        running = 0;
+        ioPadEnd();
+    }
+    return ret;
+}
+
+u32 inputPoll(inputEvent *ev)
+{
+    u32 tail = ring.tail;
+
+    if (tail == ring.head)
+        return 0;
+
+    /* Read the event only after seeing the head that published it */
+    __lwsync();
+    *ev = ring.ev[tail & (INPUT_RING_SIZE - 1)];
+    stats.events++;
+
+    /* ...and finish reading it before handing the slot back */
+    __lwsync();
+    ring.tail = tail + 1;
+
+    if (ev->pressed) {
+        if (!unflipped || ev->time < unflipped_oldest)
+            unflipped_oldest = ev->time;
+        unflipped_sum += ev->time;
+        unflipped++;
+    }
+    return 1;
+}
+
+void inputFrameFlipped(u64 now)
+{
+    double us;
+
+    stats.dropped = dropped;
+    if (!unflipped)
+        return;
+
+    /* Every press drained this frame reaches the screen with it */
+    us = timerToUsec(now - unflipped_oldest);
+    stats.last_us = us;
+    if (us > stats.max_us)
+        stats.max_us = us;
+    latency_sum    += timerToUsec(now * unflipped - unflipped_sum);
+    stats.measured += unflipped;
+    stats.avg_us    = latency_sum / stats.measured;
+    unflipped     = 0;
+    unflipped_sum = 0;
+}
+
+const inputStats *inputGetStats(void)
+{
+    return &stats;
+}
+
+void inputStop(void)
+{
+    u64 retval;
+
+    if (!running)
+        return;
+    running = 0;
+    sysThreadJoin(thread, &retval);
+    ioPadEnd();
+}
@@ -0,0 +1,70 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+/*
+ * Pad input thread. A PPU thread polls every pad port at a fixed rate and
+ * pushes timestamped button transitions into a single-producer,
+ * single-consumer ring that the main loop drains once per frame, so a
+ * press shorter than a frame is still seen and its time is known to the
+ * poll period rather than to the frame time.
+ */
+#include <ppu-types.h>
+
+#define INPUT_PADS          7       /* ports opened by ioPadInit(7) */
+#define INPUT_RING_SIZE     256     /* events; power of two */
+
+/* Button bits of inputEvent */
+#define INPUT_LEFT      (1 << 0)
+#define INPUT_DOWN      (1 << 1)
+#define INPUT_RIGHT     (1 << 2)
+#define INPUT_UP        (1 << 3)
+#define INPUT_START     (1 << 4)
+#define INPUT_R3        (1 << 5)
+#define INPUT_L3        (1 << 6)
+#define INPUT_SELECT    (1 << 7)
+#define INPUT_SQUARE    (1 << 8)
+#define INPUT_CROSS     (1 << 9)
+#define INPUT_CIRCLE    (1 << 10)
+#define INPUT_TRIANGLE  (1 << 11)
+#define INPUT_R1        (1 << 12)
+#define INPUT_L1        (1 << 13)
+#define INPUT_R2        (1 << 14)
+#define INPUT_L2        (1 << 15)
+
+typedef struct {
+    u64 time;       /* time base when the poll saw the change */
+    u32 pad;        /* port 0..INPUT_PADS-1 */
+    u32 pressed;    /* INPUT_* bits that went down */
+    u32 released;   /* INPUT_* bits that went up */
+    u32 buttons;    /* full state after the change */
+} inputEvent;
+
+/* Input-to-flip latency of the presses handled so far */
+typedef struct {
+    u32 events;         /* transitions drained by the main loop */
+    u32 dropped;        /* lost to a full ring */
+    u32 measured;       /* presses with a latency sample */
+    double last_us;     /* oldest press of the latest frame: poll -> flip queued */
+    double avg_us;      /* mean over every measured press */
+    double max_us;
+} inputStats;
+
+/* Open the pads and start polling them 'rate_hz' times a second */
+s32 inputStart(u32 rate_hz);
+
+/* Take the next event off the ring; returns 0 when it is empty */
+u32 inputPoll(inputEvent *ev);
+
+/*
+ * Call right after the frame that handled the drained presses has been
+ * queued for flip: each press drained since the previous call gets a
+ * latency sample ending at 'now'.
+ */
+void inputFrameFlipped(u64 now);
+
+const inputStats *inputGetStats(void);
+
+/* Stop and join the thread, then close the pads */
+void inputStop(void);
+
+#endif
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <malloc.h>
 
@@ -20,34 +21,59 @@
 #include <rsx/mm.h>
 #include <sysutil/video.h>
 #include <sysutil/sysutil.h>
-#include <io/pad.h>
 #include <lv2/process.h>
 #include <sys/spu.h>
 #include <sys/thread.h>
 
 #include "vecmath.h"
+#include "fill.h"
+#include "glyph.h"
+#include "input.h"
+#include "textlayer.h"
+#include "rsxdraw.h"
+#include "spuraster.h"
+#include "spupipe.h"
+#include "timer.h"
+#include "profiler.h"
+#include "startup.h"
+#include "swapchain.h"
+#include "spu_worker.h"
+#ifdef ENABLE_BENCH
+#include "bench.h"
+#endif
+#ifdef ENABLE_HEADLESS
+#include <sys/stat.h>
+#include "headless.h"
+#endif
+#ifdef ENABLE_REPLAY
+#include <sys/stat.h>
+#include "replay.h"
+#endif
 
 /* ---------- constants ---------- */
-#define MAX_BUFFERS     2
-#define FONT_W          8
-#define FONT_H          8
+#define SWAP_BUFFERS    3       /* framebuffers in rotation (2 or 3), R1 toggles */
+#define INPUT_POLL_HZ   1000    /* pad polls per second on the input thread */
+#define SPE_WORKERS     6       /* resident SPU threads (1..SPU_WORKER_MAX) */
+#define SPE_THREAD_PRIO     1000    /* SPU bring-up thread, same as main */
+#define SPE_THREAD_STACK    16384
+
+#ifdef ENABLE_REPLAY
+#define REPLAY_DIR      "/dev_hdd0/tmp/ps3text"
+#ifndef REPLAY_TRACE
+#define REPLAY_TRACE    REPLAY_DIR "/replay.bin"
+#endif
+#ifndef REPLAY_CSV
+#define REPLAY_CSV      REPLAY_DIR "/replay.csv"
+#endif
+#endif
 
 /* ---------- globals ---------- */
 static gcmContextData *context = NULL;
-static u32 curr_buf = 0;
 static u32 res_width, res_height;
 
-typedef struct {
-    u32  width;
-    u32  height;
-    u32  pitch;
-    u32 *ptr;
-    u32  offset;
-} displayBuffer;
-
-static displayBuffer buffers[MAX_BUFFERS];
-
 static int running = 1;
+static int show_profiler = 0;
+static int rsx_ok = 0;
 
 /* ---------- SPE data ---------- */
 extern const unsigned int spu_bin[];
@@ -55,117 +81,32 @@ extern const unsigned int spu_bin_size;
 
 static vecmath_data_t spe_data __attribute__((aligned(128)));
 static int spe_ok = 0;  /* 1 if SPE ran successfully */
+static int spu_raster_ok = 0;
+static int spe_pipe_ok = -1;    /* per-frame pipeline: -1 not tried yet */
 
-/* ================================================================
- *  Minimal 8x8 bitmap font (ASCII 32..126)
- *  Each character is 8 rows, each row is a byte (MSB = left pixel).
- * ================================================================ */
-static const u8 font8x8[95][8] = {
-    /* 32 ' ' */ {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
-    /* 33 '!' */ {0x18,0x18,0x18,0x18,0x18,0x00,0x18,0x00},
-    /* 34 '"' */ {0x6C,0x6C,0x24,0x00,0x00,0x00,0x00,0x00},
-    /* 35 '#' */ {0x24,0x7E,0x24,0x24,0x7E,0x24,0x00,0x00},
-    /* 36 '$' */ {0x18,0x3E,0x58,0x3C,0x1A,0x7C,0x18,0x00},
-    /* 37 '%' */ {0x62,0x64,0x08,0x10,0x26,0x46,0x00,0x00},
-    /* 38 '&' */ {0x30,0x48,0x30,0x56,0x88,0x76,0x00,0x00},
-    /* 39 ''' */ {0x18,0x18,0x10,0x00,0x00,0x00,0x00,0x00},
-    /* 40 '(' */ {0x08,0x10,0x20,0x20,0x20,0x10,0x08,0x00},
-    /* 41 ')' */ {0x20,0x10,0x08,0x08,0x08,0x10,0x20,0x00},
-    /* 42 '*' */ {0x00,0x24,0x18,0x7E,0x18,0x24,0x00,0x00},
-    /* 43 '+' */ {0x00,0x18,0x18,0x7E,0x18,0x18,0x00,0x00},
-    /* 44 ',' */ {0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x10},
-    /* 45 '-' */ {0x00,0x00,0x00,0x7E,0x00,0x00,0x00,0x00},
-    /* 46 '.' */ {0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x00},
-    /* 47 '/' */ {0x02,0x04,0x08,0x10,0x20,0x40,0x00,0x00},
-    /* 48 '0' */ {0x3C,0x46,0x4A,0x52,0x62,0x3C,0x00,0x00},
-    /* 49 '1' */ {0x18,0x38,0x18,0x18,0x18,0x7E,0x00,0x00},
-    /* 50 '2' */ {0x3C,0x42,0x04,0x18,0x20,0x7E,0x00,0x00},
-    /* 51 '3' */ {0x3C,0x42,0x0C,0x02,0x42,0x3C,0x00,0x00},
-    /* 52 '4' */ {0x08,0x18,0x28,0x48,0x7E,0x08,0x00,0x00},
-    /* 53 '5' */ {0x7E,0x40,0x7C,0x02,0x42,0x3C,0x00,0x00},
-    /* 54 '6' */ {0x1C,0x20,0x7C,0x42,0x42,0x3C,0x00,0x00},
-    /* 55 '7' */ {0x7E,0x02,0x04,0x08,0x10,0x10,0x00,0x00},
-    /* 56 '8' */ {0x3C,0x42,0x3C,0x42,0x42,0x3C,0x00,0x00},
-    /* 57 '9' */ {0x3C,0x42,0x42,0x3E,0x04,0x38,0x00,0x00},
-    /* 58 ':' */ {0x00,0x18,0x18,0x00,0x18,0x18,0x00,0x00},
-    /* 59 ';' */ {0x00,0x18,0x18,0x00,0x18,0x18,0x10,0x00},
-    /* 60 '<' */ {0x04,0x08,0x10,0x20,0x10,0x08,0x04,0x00},
-    /* 61 '=' */ {0x00,0x00,0x7E,0x00,0x7E,0x00,0x00,0x00},
-    /* 62 '>' */ {0x20,0x10,0x08,0x04,0x08,0x10,0x20,0x00},
-    /* 63 '?' */ {0x3C,0x42,0x04,0x08,0x08,0x00,0x08,0x00},
-    /* 64 '@' */ {0x3C,0x42,0x5E,0x52,0x5E,0x40,0x3C,0x00},
-    /* 65 'A' */ {0x18,0x24,0x42,0x7E,0x42,0x42,0x00,0x00},
-    /* 66 'B' */ {0x7C,0x42,0x7C,0x42,0x42,0x7C,0x00,0x00},
-    /* 67 'C' */ {0x3C,0x42,0x40,0x40,0x42,0x3C,0x00,0x00},
-    /* 68 'D' */ {0x78,0x44,0x42,0x42,0x44,0x78,0x00,0x00},
-    /* 69 'E' */ {0x7E,0x40,0x7C,0x40,0x40,0x7E,0x00,0x00},
-    /* 70 'F' */ {0x7E,0x40,0x7C,0x40,0x40,0x40,0x00,0x00},
-    /* 71 'G' */ {0x3C,0x42,0x40,0x4E,0x42,0x3C,0x00,0x00},
-    /* 72 'H' */ {0x42,0x42,0x7E,0x42,0x42,0x42,0x00,0x00},
-    /* 73 'I' */ {0x7E,0x18,0x18,0x18,0x18,0x7E,0x00,0x00},
-    /* 74 'J' */ {0x1E,0x04,0x04,0x04,0x44,0x38,0x00,0x00},
-    /* 75 'K' */ {0x44,0x48,0x70,0x48,0x44,0x42,0x00,0x00},
-    /* 76 'L' */ {0x40,0x40,0x40,0x40,0x40,0x7E,0x00,0x00},
-    /* 77 'M' */ {0x42,0x66,0x5A,0x42,0x42,0x42,0x00,0x00},
-    /* 78 'N' */ {0x42,0x62,0x52,0x4A,0x46,0x42,0x00,0x00},
-    /* 79 'O' */ {0x3C,0x42,0x42,0x42,0x42,0x3C,0x00,0x00},
-    /* 80 'P' */ {0x7C,0x42,0x42,0x7C,0x40,0x40,0x00,0x00},
-    /* 81 'Q' */ {0x3C,0x42,0x42,0x4A,0x44,0x3A,0x00,0x00},
-    /* 82 'R' */ {0x7C,0x42,0x42,0x7C,0x44,0x42,0x00,0x00},
-    /* 83 'S' */ {0x3C,0x40,0x3C,0x02,0x42,0x3C,0x00,0x00},
-    /* 84 'T' */ {0x7E,0x18,0x18,0x18,0x18,0x18,0x00,0x00},
-    /* 85 'U' */ {0x42,0x42,0x42,0x42,0x42,0x3C,0x00,0x00},
-    /* 86 'V' */ {0x42,0x42,0x42,0x24,0x24,0x18,0x00,0x00},
-    /* 87 'W' */ {0x42,0x42,0x42,0x5A,0x66,0x42,0x00,0x00},
-    /* 88 'X' */ {0x42,0x24,0x18,0x18,0x24,0x42,0x00,0x00},
-    /* 89 'Y' */ {0x42,0x42,0x24,0x18,0x18,0x18,0x00,0x00},
-    /* 90 'Z' */ {0x7E,0x04,0x08,0x10,0x20,0x7E,0x00,0x00},
-    /* 91 '[' */ {0x3C,0x20,0x20,0x20,0x20,0x3C,0x00,0x00},
-    /* 92 '\' */ {0x40,0x20,0x10,0x08,0x04,0x02,0x00,0x00},
-    /* 93 ']' */ {0x3C,0x04,0x04,0x04,0x04,0x3C,0x00,0x00},
-    /* 94 '^' */ {0x10,0x28,0x44,0x00,0x00,0x00,0x00,0x00},
-    /* 95 '_' */ {0x00,0x00,0x00,0x00,0x00,0x00,0x7E,0x00},
-    /* 96 '`' */ {0x18,0x18,0x08,0x00,0x00,0x00,0x00,0x00},
-    /* 97 'a' */ {0x00,0x00,0x3C,0x02,0x3E,0x42,0x3E,0x00},
-    /* 98 'b' */ {0x40,0x40,0x7C,0x42,0x42,0x42,0x7C,0x00},
-    /* 99 'c' */ {0x00,0x00,0x3C,0x40,0x40,0x40,0x3C,0x00},
-    /*100 'd' */ {0x02,0x02,0x3E,0x42,0x42,0x42,0x3E,0x00},
-    /*101 'e' */ {0x00,0x00,0x3C,0x42,0x7E,0x40,0x3C,0x00},
-    /*102 'f' */ {0x0C,0x10,0x3C,0x10,0x10,0x10,0x10,0x00},
-    /*103 'g' */ {0x00,0x00,0x3E,0x42,0x42,0x3E,0x02,0x3C},
-    /*104 'h' */ {0x40,0x40,0x7C,0x42,0x42,0x42,0x42,0x00},
-    /*105 'i' */ {0x18,0x00,0x38,0x18,0x18,0x18,0x3C,0x00},
-    /*106 'j' */ {0x04,0x00,0x04,0x04,0x04,0x04,0x44,0x38},
-    /*107 'k' */ {0x40,0x40,0x44,0x48,0x70,0x48,0x44,0x00},
-    /*108 'l' */ {0x38,0x18,0x18,0x18,0x18,0x18,0x3C,0x00},
-    /*109 'm' */ {0x00,0x00,0x66,0x5A,0x5A,0x42,0x42,0x00},
-    /*110 'n' */ {0x00,0x00,0x7C,0x42,0x42,0x42,0x42,0x00},
-    /*111 'o' */ {0x00,0x00,0x3C,0x42,0x42,0x42,0x3C,0x00},
-    /*112 'p' */ {0x00,0x00,0x7C,0x42,0x42,0x7C,0x40,0x40},
-    /*113 'q' */ {0x00,0x00,0x3E,0x42,0x42,0x3E,0x02,0x02},
-    /*114 'r' */ {0x00,0x00,0x5C,0x62,0x40,0x40,0x40,0x00},
-    /*115 's' */ {0x00,0x00,0x3E,0x40,0x3C,0x02,0x7C,0x00},
-    /*116 't' */ {0x10,0x10,0x7C,0x10,0x10,0x10,0x0C,0x00},
-    /*117 'u' */ {0x00,0x00,0x42,0x42,0x42,0x42,0x3E,0x00},
-    /*118 'v' */ {0x00,0x00,0x42,0x42,0x24,0x24,0x18,0x00},
-    /*119 'w' */ {0x00,0x00,0x42,0x42,0x5A,0x5A,0x66,0x00},
-    /*120 'x' */ {0x00,0x00,0x42,0x24,0x18,0x24,0x42,0x00},
-    /*121 'y' */ {0x00,0x00,0x42,0x42,0x42,0x3E,0x02,0x3C},
-    /*122 'z' */ {0x00,0x00,0x7E,0x04,0x18,0x20,0x7E,0x00},
-    /*123 '{' */ {0x0C,0x10,0x10,0x20,0x10,0x10,0x0C,0x00},
-    /*124 '|' */ {0x18,0x18,0x18,0x00,0x18,0x18,0x18,0x00},
-    /*125 '}' */ {0x30,0x08,0x08,0x04,0x08,0x08,0x30,0x00},
-    /*126 '~' */ {0x00,0x32,0x4C,0x00,0x00,0x00,0x00,0x00},
-};
+static sysSpuImage spu_image;
+static spuWorker   spu_worker;     /* resident SPU threads, see spu_worker.c */
+
+/*
+ * SPU bring-up runs on its own thread while the main thread sets up video
+ * and renders the first frames. Everything it writes is published by
+ * 'done'; the main thread reads none of it before speCollect().
+ */
+static struct {
+    volatile u32 done;
+    int ok;             /* first job completed */
+    int raster_ok;      /* SPU tile back end usable */
+} spe_bringup;
+
+static sys_ppu_thread_t spe_thread;
+static int spe_threaded = 0;    /* bring-up runs on spe_thread */
+static int spe_pending = 0;     /* results not picked up yet */
 
 /* ================================================================
  *  System event callback (handles XMB quit requests)
  * ================================================================ */
-static void sysutil_callback(u64 status, u64 param, void *usrdata)
+static void handleSysutil(u64 status)
 {
-    (void)param;
-    (void)usrdata;
-
     switch (status) {
     case SYSUTIL_EXIT_GAME:
         running = 0;
@@ -175,42 +116,22 @@ static void sysutil_callback(u64 status, u64 param, void *usrdata)
     }
 }
 
-/* ================================================================
- *  RSX video / framebuffer helpers
- * ================================================================ */
-
-/* Wait for the RSX to finish flipping the previous frame */
-static void waitFlip(void)
+static void sysutil_callback(u64 status, u64 param, void *usrdata)
 {
-    while (gcmGetFlipStatus() != 0)
-        usleep(200);
-    gcmResetFlipStatus();
-}
+    (void)param;
+    (void)usrdata;
 
-/* Request a flip to the given buffer and wait */
-static void flip(u32 buffer)
-{
-    gcmSetFlip(context, (u8)buffer);
-    rsxFlushBuffer(context);
-    gcmSetWaitFlip(context);
+#ifdef ENABLE_REPLAY
+    replaySysutil(status);
+#endif
+    handleSysutil(status);
 }
 
-/* Allocate a framebuffer in RSX memory and register it with GCM */
-static void makeBuffer(u32 id, u32 width, u32 height)
-{
-    u32 pitch = width * sizeof(u32);        /* 4 bytes per pixel, XRGB */
-    u32 size  = pitch * height;
-
-    buffers[id].ptr    = (u32 *)rsxMemalign(64, size);
-    buffers[id].width  = width;
-    buffers[id].height = height;
-    buffers[id].pitch  = pitch;
-
-    rsxAddressToOffset(buffers[id].ptr, &buffers[id].offset);
-    gcmSetDisplayBuffer(id, buffers[id].offset, pitch, width, height);
-}
+/* ================================================================
+ *  RSX video / framebuffer helpers
+ * ================================================================ */
 
-/* Detect the current video resolution and set up double-buffered display */
+/* Detect the current video resolution and set up the swapchain */
 static void initScreen(void)
 {
     videoState state;
@@ -221,12 +142,14 @@ static void initScreen(void)
     /* Allocate 1 MB of host memory for the RSX command buffer */
     host_addr = memalign(1024 * 1024, 1024 * 1024);
     context   = rsxInit(0x10000, 1024 * 1024, host_addr);
+    startupMark(STARTUP_MAIN, "rsxInit", context ? 0 : -1);
 
     /* Query current video output state */
-    videoGetState(0, 0, &state);
+    startupMark(STARTUP_MAIN, "videoGetState", videoGetState(0, 0, &state));
 
     /* Get pixel dimensions for the active resolution */
-    videoGetResolution(state.displayMode.resolution, &resolution);
+    startupMark(STARTUP_MAIN, "videoGetResolution",
+                videoGetResolution(state.displayMode.resolution, &resolution));
     res_width  = resolution.width;
     res_height = resolution.height;
 
@@ -235,190 +158,447 @@ static void initScreen(void)
     vconfig.resolution = state.displayMode.resolution;
     vconfig.format     = VIDEO_BUFFER_FORMAT_XRGB;
     vconfig.pitch      = res_width * sizeof(u32);
-    videoConfigure(0, &vconfig, NULL, 0);
+    startupMark(STARTUP_MAIN, "videoConfigure", videoConfigure(0, &vconfig, NULL, 0));
     videoGetState(0, 0, &state);
 
     gcmSetFlipMode(GCM_FLIP_VSYNC);
 
-    /* Create two framebuffers for double buffering */
-    makeBuffer(0, res_width, res_height);
-    makeBuffer(1, res_width, res_height);
+    /* Framebuffers + flip handler; shows buffer 0 */
+    if (startupMark(STARTUP_MAIN, "swapInit",
+                    swapInit(context, res_width, res_height, SWAP_BUFFERS)) != 0)
+        printf("swapchain: no flip event queue, polling\n");
+}
+
+/* ================================================================
+ *  SPE bring-up (runs concurrently with initScreen)
+ * ================================================================ */
+
+/* Start the SPU workers and run the first vector job on them */
+static void speBringUp(void)
+{
+    u32 result = 0;
+    s32 ret;
+
+    /* Fill input vector: (1.0, 2.0, 3.0, 4.0) */
+    spe_data.input[0] = 1.0f;
+    spe_data.input[1] = 2.0f;
+    spe_data.input[2] = 3.0f;
+    spe_data.input[3] = 4.0f;
+    spe_data.done = 0;
+
+    printf("SPE: sizeof(vecmath_data_t)=%u addr=%p\n",
+           (unsigned int)sizeof(vecmath_data_t), &spe_data);
+
+    /* Initialize SPU subsystem (6 SPEs available on Cell BE) */
+    startupMark(STARTUP_SPE, "sysSpuInitialize", sysSpuInitialize(6, 0));
+
+    /* Load SPU image from embedded binary */
+    ret = sysSpuImageImport(&spu_image, spu_bin, 0);
+    startupMark(STARTUP_SPE, "sysSpuImageImport", ret);
+    printf("SPE: image entry=0x%x segs=%u\n", spu_image.entryPoint, spu_image.segmentCount);
+
+    /* Start the resident workers; they stay up until exit */
+    ret = spuWorkerStart(&spu_worker, &spu_image, SPE_WORKERS);
+    startupMark(STARTUP_SPE, "spuWorkerStart", ret);
+    printf("SPE: group=%u threads=%u\n", spu_worker.group_id, spu_worker.count);
+
+    startupMark(STARTUP_SPE, "spuWorkerSubmit",
+                spuWorkerSubmit(&spu_worker, 0, VECMATH_KERNEL_SINGLE, &spe_data, 1, 0));
+
+    startupMark(STARTUP_SPE, "spuWorkerWait", spuWorkerWait(&spu_worker, 0, 0, &result));
+    printf("SPE: first job result=%u\n", result);
+
+    if (spe_data.done) {
+        spe_bringup.ok = 1;
+        printf("SPE done: dot=%.2f mag=%.2f\n", spe_data.dot_product, spe_data.magnitude);
+    } else {
+        printf("SPE did not complete (done=%u)\n", spe_data.done);
+    }
+
+    spe_bringup.raster_ok = spu_worker.running &&
+        startupMark(STARTUP_SPE, "spuDrawInit", spuDrawInit(&spu_worker)) == 0;
+
+    /* Results and worker state before the flag that hands them over */
+    __lwsync();
+    spe_bringup.done = 1;
+}
 
-    gcmResetFlipStatus();
-    flip(curr_buf);
+static void speThread(void *arg)
+{
+    (void)arg;
+    speBringUp();
+    sysThreadExit(0);
+}
+
+/* Start the bring-up; falls back to running it inline without a thread */
+static void speStart(void)
+{
+    s32 ret;
+
+    ret = sysThreadCreate(&spe_thread, speThread, NULL, SPE_THREAD_PRIO,
+                          SPE_THREAD_STACK, THREAD_JOINABLE, "spe bring-up");
+    startupMark(STARTUP_MAIN, "sysThreadCreate(spe)", ret);
+    spe_threaded = ret == 0;
+    spe_pending  = 1;
+    if (!spe_threaded)
+        speBringUp();
+}
+
+/*
+ * Pick up the bring-up results once the thread has finished, or block
+ * until it has if 'wait'. Returns 1 when spe_ok / spu_raster_ok are final.
+ */
+static int speCollect(int wait)
+{
+    u64 retval;
+
+    if (!spe_pending)
+        return 1;
+    if (!wait && !spe_bringup.done)
+        return 0;
+    if (spe_threaded)
+        startupMark(STARTUP_MAIN, "sysThreadJoin(spe)", sysThreadJoin(spe_thread, &retval));
+    spe_ok        = spe_bringup.ok;
+    spu_raster_ok = spe_bringup.raster_ok;
+    spe_pending   = 0;
+    return 1;
+}
+
+/*
+ * speCollect(0) for the main loop. The frame the results arrive on varies
+ * from run to run, so a recording logs it and a replay waits for the
+ * results on that same frame instead (see replayDispatch()).
+ */
+static int speFrameCollect(void)
+{
+#ifdef ENABLE_REPLAY
+    if (replayPlaying())
+        return !spe_pending;
+    if (spe_pending && speCollect(0)) {
+        replaySpe((spe_ok ? REPLAY_SPE_OK : 0) | (spu_raster_ok ? REPLAY_SPE_RASTER : 0));
+        return 1;
+    }
+#endif
+    return speCollect(0);
 }
 
 /* ================================================================
  *  Drawing primitives (software rasterisation to framebuffer)
  * ================================================================ */
 
-/* Fill the entire framebuffer with a solid colour (XRGB) */
-static void clearScreen(u32 color)
+/*
+ * Frame text goes through the retained text layer: drawString() only
+ * declares a string, and endFrame() clears and redraws what changed in
+ * the current buffer (or everything, in TEXT_REDRAW_FULL mode).
+ */
+static textLayer text;
+
+/* Start a frame with a solid background colour (XRGB) */
+static void beginFrame(u32 color)
 {
-    u32 *fb    = buffers[curr_buf].ptr;
-    u32  count = buffers[curr_buf].width * buffers[curr_buf].height;
-    u32  i;
-    for (i = 0; i < count; i++)
-        fb[i] = color;
+    textLayerBegin(&text, color);
 }
 
-/* Draw a single character at pixel position (px, py) with scale factor */
-static void drawChar(u32 *fb, u32 pitch, char c, u32 px, u32 py,
-                     u32 fg, u32 scale)
+/* Draw a null-terminated string at (x, y) with given colour and scale */
+static void drawString(const char *str, u32 x, u32 y, u32 color, u32 scale)
 {
-    const u8 *glyph;
-    u32 row, col, sy, sx;
-
-    if (c < 32 || c > 126)
-        c = '?';
-    glyph = font8x8[c - 32];
-
-    for (row = 0; row < FONT_H; row++) {
-        u8 bits = glyph[row];
-        for (col = 0; col < FONT_W; col++) {
-            if (bits & (0x80 >> col)) {
-                /* scale the pixel */
-                for (sy = 0; sy < scale; sy++) {
-                    for (sx = 0; sx < scale; sx++) {
-                        u32 x = px + col * scale + sx;
-                        u32 y = py + row * scale + sy;
-                        if (x < res_width && y < res_height)
-                            fb[y * (pitch / 4) + x] = fg;
-                    }
-                }
-            }
+    PROF_BEGIN(PROF_DRAW);
+    textLayerAdd(&text, str, x, y, color, scale);
+    PROF_END(PROF_DRAW);
+}
+
+/* sprintf, timed as its own phase */
+static void formatString(char *buf, const char *fmt, ...)
+{
+    va_list ap;
+
+    PROF_BEGIN(PROF_FORMAT);
+    va_start(ap, fmt);
+    vsprintf(buf, fmt, ap);
+    va_end(ap);
+    PROF_END(PROF_FORMAT);
+}
+
+/* Render the declared frame into the acquired buffer; the background
+ * fills inside it count as PROF_CLEAR, the rest as PROF_RENDER */
+static void endFrame(const swapBuffer *b)
+{
+    glyphTarget t;
+
+    PROF_BEGIN(PROF_RENDER);
+    t.ptr    = b->ptr;
+    t.width  = b->width;
+    t.height = b->height;
+    t.pitch  = b->pitch;
+    t.offset = b->offset;
+    textLayerEnd(&text, &t, swapCurrent());
+    PROF_END(PROF_RENDER);
+    PROF_MOVE(PROF_RENDER, PROF_CLEAR, text.stats.clear_ticks);
+}
+
+/* ================================================================
+ *  Pad input
+ * ================================================================ */
+
+/* Act on one pad transition */
+static void handlePad(const inputEvent *ev)
+{
+    u32 down = ev->pressed;
+
+    if (down & INPUT_CROSS)
+        running = 0;
+
+    /* Square toggles dirty-rectangle / full redraw */
+    if (down & INPUT_SQUARE) {
+        text.mode = text.mode == TEXT_REDRAW_DIRTY ? TEXT_REDRAW_FULL
+                                                   : TEXT_REDRAW_DIRTY;
+        textLayerInvalidate(&text);
+    }
+
+    /* Triangle cycles the PPU software / RSX / SPU tile back ends */
+    if (down & INPUT_TRIANGLE) {
+        const textBackend *next = &textBackendSoftware;
+
+        if (text.backend == &textBackendSoftware && rsx_ok)
+            next = &textBackendRsx;
+        else if (text.backend != &textBackendSpu && spu_raster_ok)
+            next = &textBackendSpu;
+        textLayerSetBackend(&text, next);
+    }
+
+    /* Circle toggles the profiler overlay */
+    if (down & INPUT_CIRCLE)
+        show_profiler = !show_profiler;
+
+    /* R1 switches between double and triple buffering */
+    if (down & INPUT_R1) {
+        swapSetCount(swapGetCount() == 3 ? 2 : 3);
+        textLayerInvalidate(&text);
+    }
+
+    /* L1 switches the software fills between VMX and scalar */
+    if (down & INPUT_L1) {
+        fillSetPath(fillGetPath() == FILL_PATH_VECTOR ? FILL_PATH_SCALAR
+                                                      : FILL_PATH_VECTOR);
+        textLayerInvalidate(&text);
+    }
+}
+
+#ifdef ENABLE_REPLAY
+/* Replaying: this frame's recorded events, in the order they were handled */
+static void replayDispatch(void)
+{
+    replayRecord r;
+    inputEvent ev;
+
+    while (replayNext(&r)) {
+        switch (r.kind) {
+        case REPLAY_PAD:
+            memset(&ev, 0, sizeof(ev));
+            ev.pad      = r.pad;
+            ev.pressed  = r.pressed;
+            ev.released = r.released;
+            ev.buttons  = r.buttons;
+            handlePad(&ev);
+            break;
+        case REPLAY_SYSUTIL:
+            handleSysutil(r.v0);
+            break;
+        case REPLAY_SPE:
+            speCollect(1);
+            if (r.v0 != ((spe_ok ? REPLAY_SPE_OK : 0) | (spu_raster_ok ? REPLAY_SPE_RASTER : 0)))
+                printf("replay: SPE bring-up differs from the recording (0x%x)\n", r.v0);
+            break;
+        default:
+            break;
         }
     }
 }
+#endif
 
-/* Draw a null-terminated string at (x, y) with given colour and scale */
-static void drawString(const char *str, u32 x, u32 y, u32 color, u32 scale)
+#ifdef ENABLE_PROFILE
+#define PROF_HUD_REFRESH    30      /* frames between overlay updates */
+
+/* Profiler overlay: one line per phase, refreshed every PROF_HUD_REFRESH frames */
+static void drawProfiler(u32 x, u32 y)
 {
-    u32 *fb    = buffers[curr_buf].ptr;
-    u32  pitch = buffers[curr_buf].pitch;
-    u32  cx    = x;
-
-    while (*str) {
-        if (*str == '\n') {
-            cx = x;
-            y += FONT_H * scale + 2;
-        } else {
-            drawChar(fb, pitch, *str, cx, y, color, scale);
-            cx += FONT_W * scale;
+    static char lines[PROF_PHASES][64];
+    static u32  last_refresh;
+    int p;
+
+    if (profFrames() - last_refresh >= PROF_HUD_REFRESH || !lines[0][0]) {
+        for (p = 0; p < PROF_PHASES; p++) {
+            profSummary s;
+
+            profSummarize(p, &s);
+            formatString(lines[p], "%-10s %7.1f %7.1f %7.1f %7.1f",
+                         profPhaseName(p), s.min_us, s.avg_us, s.p99_us, s.max_us);
         }
-        str++;
+        last_refresh = profFrames();
     }
+
+    drawString("phase (us)     min     avg     p99     max", x, y, 0x00FFD700, 1);
+    for (p = 0; p < PROF_PHASES; p++)
+        drawString(lines[p], x, y + 12 * (p + 1), 0x00AAAAAA, 1);
 }
+#endif
+
+#ifdef ENABLE_HEADLESS
+#define HEADLESS_WIDTH      1280
+#define HEADLESS_HEIGHT     720
+#define HEADLESS_FRAMES     600
+#define HEADLESS_DIR        "/dev_hdd0/tmp/ps3text"
+
+/* Frames written to HEADLESS_DIR (and compared, with GOLDEN=<dir>) */
+static const u32 headless_dump[] = { 0, 1, 2, 3, 59, HEADLESS_FRAMES - 1 };
+
+/* Offscreen run in place of the display: no RSX, video setup or flip */
+static int runHeadless(void)
+{
+    headlessConfig c;
+    headlessResult r;
+    int m;
+
+    mkdir(HEADLESS_DIR, 0777);
+
+    memset(&c, 0, sizeof(c));
+    c.width      = HEADLESS_WIDTH;
+    c.height     = HEADLESS_HEIGHT;
+    c.frames     = HEADLESS_FRAMES;
+    c.buffers    = SWAP_BUFFERS;
+    c.dump       = headless_dump;
+    c.dump_count = sizeof(headless_dump) / sizeof(headless_dump[0]);
+    c.dump_dir   = HEADLESS_DIR;
+#ifdef HEADLESS_GOLDEN
+    c.golden_dir = HEADLESS_GOLDEN;
+#endif
+
+    /* Both redraw modes; only the last one's dumps are kept */
+    for (m = 0; m < 2; m++) {
+        c.mode = m ? TEXT_REDRAW_DIRTY : TEXT_REDRAW_FULL;
+        if (headlessRun(&c, &r) != 0) {
+            printf("headless: out of memory\n");
+            return 1;
+        }
+        printf("headless: %s/%s %ux%u %u frames %.3f s  %.1f frames/s  checksum 0x%08x  "
+               "dumped %u compared %u mismatched %u\n",
+               m ? "dirty" : "full", fillGetPath() == FILL_PATH_VECTOR ? "vmx" : "scalar",
+               c.width, c.height, r.frames, timerToSec(r.ticks), r.fps, r.checksum,
+               r.dumped, r.compared, r.mismatched);
+        if (r.mismatched)
+            return 1;
+    }
+    return 0;
+}
+#endif
 
 /* ================================================================
  *  Main
  * ================================================================ */
 int main(int argc, const char *argv[])
 {
-    padInfo  padinfo;
-    padData  paddata;
+    inputEvent ev;
     u32      frame = 0;
+    swapBuffer *fb;
+#ifdef ENABLE_REPLAY
+    u64      wait;
+#endif
 
     (void)argc;
     (void)argv;
 
-    /* Initialise subsystems */
+#ifdef ENABLE_HEADLESS
+    sysProcessExit(runHeadless());
+#endif
+
+    /* Initialise subsystems; the SPU side comes up in parallel */
+    startupBegin();
+    speStart();
     initScreen();
-    ioPadInit(7);                          /* support up to 7 pads */
-    sysUtilRegisterCallback(0, sysutil_callback, NULL);
+    textLayerInit(&text, TEXT_REDRAW_DIRTY);
+    rsx_ok = startupMark(STARTUP_MAIN, "rsxDrawInit",
+                         rsxDrawInit(context, 1920, 1080)) == 0;   /* largest video mode */
+    startupMark(STARTUP_MAIN, "inputStart",
+                inputStart(INPUT_POLL_HZ));    /* polls all 7 pads on its own thread */
+    startupMark(STARTUP_MAIN, "sysUtilRegisterCallback",
+                sysUtilRegisterCallback(0, sysutil_callback, NULL));
 
     printf("RSX framebuffer text demo started\n");
 
-    /* ---- Run SPE vector calculation ---- */
-    {
-        sysSpuImage spu_image;
-        u32 group_id;
-        u32 thread_id;
-        u32 cause, status;
-        s32 ret;
-
-        /* Fill input vector: (1.0, 2.0, 3.0, 4.0) */
-        spe_data.input[0] = 1.0f;
-        spe_data.input[1] = 2.0f;
-        spe_data.input[2] = 3.0f;
-        spe_data.input[3] = 4.0f;
-        spe_data.done = 0;
-
-        printf("SPE: sizeof(vecmath_data_t)=%u addr=%p\n",
-               (unsigned int)sizeof(vecmath_data_t), &spe_data);
-
-        /* Initialize SPU subsystem (6 SPEs available on Cell BE) */
-        ret = sysSpuInitialize(6, 0);
-        printf("SPE: sysSpuInitialize ret=%d\n", ret);
-
-        /* Load SPU image from embedded binary */
-        ret = sysSpuImageImport(&spu_image, spu_bin, 0);
-        printf("SPE: sysSpuImageImport ret=%d entry=0x%x segs=%u\n",
-               ret, spu_image.entryPoint, spu_image.segmentCount);
-
-        /* Create thread group */
-        sysSpuThreadGroupAttribute grpattr;
-        memset(&grpattr, 0, sizeof(grpattr));
-        grpattr.nameSize = 7;
-        grpattr.nameAddress = (u32)(uintptr_t)"spugrp";
-        grpattr.groupType = 0;
-        grpattr.memContainer = 0;
-        ret = sysSpuThreadGroupCreate(&group_id, 1, 100, &grpattr);
-        printf("SPE: sysSpuThreadGroupCreate ret=%d group=%u\n", ret, group_id);
-
-        /* Create SPU thread */
-        sysSpuThreadAttribute thattr;
-        memset(&thattr, 0, sizeof(thattr));
-        thattr.nameAddress = (u32)(uintptr_t)"sputhr";
-        thattr.nameSize = 7;
-        thattr.attribute = SPU_THREAD_ATTR_NONE;
-
-        sysSpuThreadArgument arg;
-        arg.arg0 = (u64)(uintptr_t)&spe_data;
-        arg.arg1 = 0;
-        arg.arg2 = 0;
-        arg.arg3 = 0;
-        ret = sysSpuThreadInitialize(&thread_id, group_id, 0, &spu_image, &thattr, &arg);
-        printf("SPE: sysSpuThreadInitialize ret=%d thread=%u\n", ret, thread_id);
-
-        /* Start and wait for completion */
-        ret = sysSpuThreadGroupStart(group_id);
-        printf("SPE: sysSpuThreadGroupStart ret=%d\n", ret);
-
-        printf("SPE: waiting for join...\n");
-        ret = sysSpuThreadGroupJoin(group_id, &cause, &status);
-        printf("SPE: sysSpuThreadGroupJoin ret=%d cause=%u status=%u\n", ret, cause, status);
-
-        if (spe_data.done) {
-            spe_ok = 1;
-            printf("SPE done: dot=%.2f mag=%.2f\n", spe_data.dot_product, spe_data.magnitude);
-        } else {
-            printf("SPE did not complete (done=%u)\n", spe_data.done);
-        }
-
-        sysSpuImageClose(&spu_image);
-    }
+#ifdef ENABLE_REPLAY
+    mkdir(REPLAY_DIR, 0777);
+    if (replayStart(REPLAY_MODE, REPLAY_TRACE, REPLAY_CSV,
+                    res_width, res_height, SWAP_BUFFERS) != 0)
+        printf("replay: can't open %s, running live\n", REPLAY_TRACE);
+    /* Full speed: flips complete on the next hsync instead of the vsync */
+    if (replayGetMode() == REPLAY_FAST)
+        gcmSetFlipMode(GCM_FLIP_HSYNC);
+#endif
+
+#ifdef ENABLE_BENCH
+    /* The benchmarks need the workers: startup is serial in this build */
+    speCollect(1);
+    runBenchmarks(&spu_image, &spu_worker, context);
+#endif
 
     /* Main loop */
     while (running) {
+        PROF_BEGIN(PROF_FRAME);
+#ifdef ENABLE_REPLAY
+        replayFrameBegin();
+#endif
+
         /* Check for system events (XMB quit, etc.) */
+        PROF_BEGIN(PROF_CALLBACK);
         sysUtilCheckCallback();
-
-        /* Poll controller */
-        ioPadGetInfo(&padinfo);
-        if (padinfo.status[0]) {
-            ioPadGetData(0, &paddata);
-
-            if (paddata.BTN_CROSS) {
-                running = 0;
-            }
+        PROF_END(PROF_CALLBACK);
+
+#ifdef ENABLE_REPLAY
+        /* Replaying: the recorded pad, sysutil and SPE events of this frame */
+        PROF_BEGIN(PROF_PAD);
+        replayDispatch();
+        PROF_END(PROF_PAD);
+#endif
+
+        /* Pick up the SPE results once the bring-up thread is done, then
+         * move the per-frame batches onto the last worker */
+        if (speFrameCollect() && spe_ok && spe_pipe_ok < 0)
+            spe_pipe_ok = startupMark(STARTUP_MAIN, "spuPipeStart",
+                                      spuPipeStart(&spu_worker, spu_worker.count - 1)) == 0;
+
+        /* Handle the pad transitions the input thread queued since last frame */
+        PROF_BEGIN(PROF_PAD);
+        while (inputPoll(&ev)) {
+#ifdef ENABLE_REPLAY
+            /* Live input is drained but not acted on during a replay */
+            if (replayPlaying())
+                continue;
+            replayPad(&ev);
+#endif
+            handlePad(&ev);
         }
+        PROF_END(PROF_PAD);
+
+        /* Pick up last frame's SPU batch and submit this one; the SPU runs
+         * it while the PPU renders and waits for the flip */
+        spuPipeFrame(frame);
 
         /* ---- Render frame ---- */
-        waitFlip();
+        PROF_BEGIN(PROF_WAIT_FLIP);
+#ifdef ENABLE_REPLAY
+        wait = timerNow();
+        fb   = swapAcquire();
+        wait = timerNow() - wait;
+#else
+        fb = swapAcquire();
+#endif
+        PROF_END(PROF_WAIT_FLIP);
+
+        /* Redraw stats of the previous frame, before they are reset */
+        textStats stats = text.stats;
 
         /* Dark blue background */
-        clearScreen(0x00102040);
+        beginFrame(0x00102040);
 
         /* Title (scale 4x) */
         drawString("Hola Mundo PS3!", 80, 60, 0x00FFFFFF, 4);
@@ -427,57 +607,166 @@ int main(int argc, const char *argv[])
         drawString("RSX framebuffer + bitmap font demo", 80, 130, 0x0000CC00, 2);
 
         /* Instructions */
-        drawString("Press X (cross) to exit", 80, 180, 0x00CCCCCC, 2);
+        drawString("Press X to exit, [] redraw mode, /\\ back end,", 80, 180, 0x00CCCCCC, 2);
+        drawString("O profiler, R1 buffers, L1 VMX/scalar fills", 80, 205, 0x00CCCCCC, 2);
 
         /* Frame counter */
         {
-            char info[64];
-            sprintf(info, "Frame: %u", frame);
+            const inputStats *is = inputGetStats();
+            char info[96];
+
+            formatString(info, "Frame: %u  input->flip %.1f ms (avg %.1f, max %.1f)",
+                         frame, is->last_us / 1000.0, is->avg_us / 1000.0,
+                         is->max_us / 1000.0);
             drawString(info, 80, 240, 0x00AAAAAA, 2);
         }
 
-        /* Resolution info */
+        /* Resolution info, and time to first frame / SPE ready */
         {
-            char res[64];
-            sprintf(res, "Resolution: %ux%u", res_width, res_height);
+            const startupSummary *su = startupGetSummary();
+            char res[96];
+
+            if (spe_pending)
+                formatString(res, "Resolution: %ux%u  startup: frame %.1f ms, SPE pending",
+                             res_width, res_height, su->first_frame_ms);
+            else
+                formatString(res, "Resolution: %ux%u  startup: frame %.1f ms, SPE %.1f ms",
+                             res_width, res_height, su->first_frame_ms,
+                             su->lane_ms[STARTUP_SPE]);
             drawString(res, 80, 280, 0x00AAAAAA, 2);
         }
 
         /* SPE results */
-        if (spe_ok) {
+        if (spe_pending) {
+            drawString("SPE: starting...", 80, 340, 0x00FFD700, 2);
+        } else if (spe_ok) {
             char buf[128];
 
             drawString("--- SPE Vector Math ---", 80, 340, 0x00FFD700, 2);
 
-            sprintf(buf, "Input:  (%.1f, %.1f, %.1f, %.1f)",
+            formatString(buf, "Input:  (%.1f, %.1f, %.1f, %.1f)",
                     spe_data.input[0], spe_data.input[1],
                     spe_data.input[2], spe_data.input[3]);
             drawString(buf, 80, 370, 0x0099CCFF, 2);
 
-            sprintf(buf, "Output: (%.1f, %.1f, %.1f, %.1f)",
+            formatString(buf, "Output: (%.1f, %.1f, %.1f, %.1f)",
                     spe_data.output[0], spe_data.output[1],
                     spe_data.output[2], spe_data.output[3]);
             drawString(buf, 80, 400, 0x0099CCFF, 2);
 
-            sprintf(buf, "Dot product: %.2f", spe_data.dot_product);
+            formatString(buf, "Dot product: %.2f", spe_data.dot_product);
             drawString(buf, 80, 430, 0x0099CCFF, 2);
 
-            sprintf(buf, "Magnitude:   %.2f", spe_data.magnitude);
+            formatString(buf, "Magnitude:   %.2f", spe_data.magnitude);
             drawString(buf, 80, 460, 0x0099CCFF, 2);
         } else {
             drawString("SPE: not available", 80, 340, 0x00FF4444, 2);
         }
 
-        /* Flip to display the frame we just drew */
-        flip(curr_buf);
-        curr_buf = !curr_buf;
+        /* Framebuffer bandwidth of the last frame */
+        {
+            char buf[96];
+            formatString(buf, "Redraw: %s/%s/%s  written %u KB (%u rects, %u strings)",
+                    text.mode == TEXT_REDRAW_FULL ? "full" : "dirty", text.backend->name,
+                    fillGetPath() == FILL_PATH_VECTOR ? "vmx" : "scalar",
+                    (stats.bytes_cleared + stats.bytes_text) / 1024,
+                    stats.rects, stats.items_drawn);
+            drawString(buf, 80, 500, 0x00AAAAAA, 2);
+        }
+
+        /* Per-tile SPU timings of the last frame */
+        if (text.backend == &textBackendSpu) {
+            const spuDrawStats *ts = spuDrawGetStats();
+            char buf[96];
+
+            formatString(buf, "SPU tiles: %u/%u  avg %.1f us  max %.1f us",
+                    ts->tiles_drawn, ts->tiles,
+                    timerToUsec(ts->ticks_avg), timerToUsec(ts->ticks_max));
+            drawString(buf, 80, 530, 0x00AAAAAA, 2);
+        }
+
+        /* Per-frame SPU batches: latest result, latency and hidden work */
+        if (spe_pipe_ok > 0) {
+            const spuPipeStats *ps = spuPipeGetStats();
+            const vecmath_vec_t *v;
+            u32 from = 0;
+            char buf[112];
+
+            formatString(buf, "SPU pipe: latency %u frames (avg %.2f, max %u)  hidden %.0f%%  stalls %u",
+                         ps->latency, ps->latency_avg, ps->latency_max,
+                         ps->hidden_pct, ps->stalls);
+            drawString(buf, 80, 590, 0x00AAAAAA, 2);
+
+            if ((v = spuPipeResults(&from)) != NULL) {
+                formatString(buf, "  frame %u: %u vectors, v[0] dot %.3f mag %.3f",
+                             from, SPUPIPE_VECTORS, v[0].dot_product, v[0].magnitude);
+                drawString(buf, 80, 620, 0x0099CCFF, 2);
+            }
+        }
+
+        /* Frame pacing over the last SWAP_STATS_FRAMES frames */
+        {
+            const swapStats *ss = swapGetStats();
+            char buf[96];
+
+            formatString(buf, "Swap: %u buffers  missed vsyncs %u (%u total)  PPU idle %.1f%%",
+                         swapGetCount(), ss->missed_window, ss->missed, ss->idle_pct);
+            drawString(buf, 80, 560, 0x00AAAAAA, 2);
+        }
+
+#ifdef ENABLE_PROFILE
+        if (show_profiler)
+            drawProfiler(res_width > 480 ? res_width - 400 : 0, 240);
+#endif
+
+        endFrame(fb);
+
+        /* Queue the flip; the next swapAcquire() waits only if it must */
+        PROF_BEGIN(PROF_FLIP);
+        swapPresent();
+        PROF_END(PROF_FLIP);
+        inputFrameFlipped(timerNow());
+        if (frame == 0)
+            startupFirstFrame();
         frame++;
+
+#ifdef ENABLE_REPLAY
+        replayFrameEnd(wait);
+        if (replayDone())
+            running = 0;
+#endif
+        PROF_END(PROF_FRAME);
+        PROF_FRAME_END();
     }
 
     /* Clean up */
     printf("Exiting...\n");
-    ioPadEnd();
-    gcmSetWaitFlip(context);
+#ifdef ENABLE_REPLAY
+    replayStop();
+#endif
+    {
+        const swapStats *ss = swapGetStats();
+
+        printf("swap: %u buffers, %u frames, %u missed vsyncs, PPU idle %.3f s\n",
+               swapGetCount(), ss->presented, ss->missed, timerToSec(ss->idle_ticks));
+    }
+#ifdef ENABLE_PROFILE
+    profDump();
+#endif
+    speCollect(1);
+    if (spe_pipe_ok > 0) {
+        const spuPipeStats *ps = spuPipeGetStats();
+
+        printf("spupipe: %u batches (%u skipped), latency avg %.2f max %u frames, "
+               "batch %.1f us, stalled %.1f us in %u, hidden %.1f%%\n",
+               ps->completed, ps->skipped, ps->latency_avg, ps->latency_max,
+               ps->batch_us, ps->stall_us, ps->stalls, ps->hidden_pct);
+    }
+    spuPipeStop();
+    spuWorkerStop(&spu_worker);
+    sysSpuImageClose(&spu_image);
+    inputStop();
+    swapShutdown();
     rsxFinish(context, 1);
 
     sysProcessExit(0);
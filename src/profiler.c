@@ -0,0 +1,114 @@
+/*
+ * Per-phase frame profiler (see profiler.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profiler.h"
+
+profPhaseData profPhases[PROF_PHASES];
+
+static u32 frames;
+
+static const char *phase_names[PROF_PHASES] = {
+    "callback", "pad", "waitFlip", "clear", "drawString",
+    "sprintf", "render", "flip", "frame",
+};
+
+const char *profPhaseName(profPhase p)
+{
+    return phase_names[p];
+}
+
+u32 profFrames(void)
+{
+    return frames;
+}
+
+/* Bucket b holds [2^(b-1), 2^b) us; bucket 0 is < 1 us */
+static u32 bucketOf(u64 ticks)
+{
+    u64 us = (u64)timerToUsec(ticks);
+    u32 b = 0;
+
+    while (us && b < PROF_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void profFrameEnd(void)
+{
+    u32 slot = frames % PROF_WINDOW;
+    int p;
+
+    for (p = 0; p < PROF_PHASES; p++) {
+        profPhaseData *d = &profPhases[p];
+        u64 t = d->accum;
+
+        d->window[slot] = t > 0xffffffffULL ? 0xffffffff : (u32)t;
+        d->hist[bucketOf(t)]++;
+        d->total += t;
+        d->accum  = 0;
+    }
+    frames++;
+}
+
+static int cmpTicks(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+    return x < y ? -1 : x > y;
+}
+
+void profSummarize(profPhase p, profSummary *out)
+{
+    static u32 sorted[PROF_WINDOW];
+    u32 n = frames < PROF_WINDOW ? frames : PROF_WINDOW;
+    u64 sum = 0;
+    u32 i;
+
+    memset(out, 0, sizeof(*out));
+    if (!n)
+        return;
+
+    memcpy(sorted, profPhases[p].window, n * sizeof(u32));
+    qsort(sorted, n, sizeof(u32), cmpTicks);
+    for (i = 0; i < n; i++)
+        sum += sorted[i];
+
+    out->min_us = timerToUsec(sorted[0]);
+    out->avg_us = timerToUsec(sum) / n;
+    out->p99_us = timerToUsec(sorted[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1]);
+    out->max_us = timerToUsec(sorted[n - 1]);
+}
+
+void profDump(void)
+{
+    int p, b;
+
+    printf("prof: %u frames, last %u in window (us)\n",
+           frames, frames < PROF_WINDOW ? frames : PROF_WINDOW);
+    printf("prof: %-10s %9s %9s %9s %9s %11s\n",
+           "phase", "min", "avg", "p99", "max", "total avg");
+
+    for (p = 0; p < PROF_PHASES; p++) {
+        profSummary s;
+
+        profSummarize(p, &s);
+        printf("prof: %-10s %9.1f %9.1f %9.1f %9.1f %11.1f\n",
+               phase_names[p], s.min_us, s.avg_us, s.p99_us, s.max_us,
+               frames ? timerToUsec(profPhases[p].total) / frames : 0.0);
+    }
+
+    /* One line per phase: frame counts per power-of-two microsecond bucket */
+    printf("prof: histogram buckets <1us <2 <4 ... <16384 >=16384\n");
+    for (p = 0; p < PROF_PHASES; p++) {
+        printf("prof: hist %-10s", phase_names[p]);
+        for (b = 0; b < PROF_BUCKETS; b++)
+            printf(" %u", profPhases[p].hist[b]);
+        printf("\n");
+    }
+}
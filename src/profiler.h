@@ -0,0 +1,77 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+/*
+ * Per-phase frame profiler on the time-base register.
+ *
+ * PROF_BEGIN/PROF_END bracket a phase of the main loop; a phase entered
+ * several times in one frame (drawString, sprintf) accumulates. At the end
+ * of each frame profFrameEnd() pushes every phase's total into a rolling
+ * window (min/avg/p99/max) and a log2 histogram in microseconds.
+ *
+ * Built with PROFILE=0 the probes expand to nothing; otherwise a probe is
+ * one __mftb() and a store.
+ */
+#include <ppu-types.h>
+
+#include "timer.h"
+
+typedef enum {
+    PROF_CALLBACK = 0,      /* sysUtilCheckCallback */
+    PROF_PAD,               /* inputPoll: drain the input ring, handlePad */
+    PROF_WAIT_FLIP,         /* waiting for the previous flip */
+    PROF_CLEAR,             /* textLayerEnd: back end fills of the background */
+    PROF_DRAW,              /* drawString: declaring strings */
+    PROF_FORMAT,            /* sprintf */
+    PROF_RENDER,            /* endFrame: everything else, text into the buffer */
+    PROF_FLIP,              /* queueing the flip */
+    PROF_FRAME,             /* whole loop iteration */
+    PROF_PHASES
+} profPhase;
+
+#define PROF_WINDOW     256     /* frames kept for min/avg/p99 */
+#define PROF_BUCKETS    16      /* histogram: <1us, <2us, <4us ... >=16ms */
+
+typedef struct {
+    u64 start;                  /* time base at PROF_BEGIN */
+    u64 accum;                  /* ticks spent in the current frame */
+    u32 window[PROF_WINDOW];    /* per-frame ticks, ring buffer */
+    u32 hist[PROF_BUCKETS];     /* frames per bucket since start */
+    u64 total;                  /* ticks since start */
+} profPhaseData;
+
+typedef struct {
+    double min_us, avg_us, p99_us, max_us;
+} profSummary;
+
+extern profPhaseData profPhases[PROF_PHASES];
+
+#ifdef ENABLE_PROFILE
+#define PROF_BEGIN(p)   (profPhases[p].start = timerNow())
+#define PROF_END(p)     (profPhases[p].accum += timerNow() - profPhases[p].start)
+/* Charge 't' ticks already counted in phase 'from' to phase 'to' instead */
+#define PROF_MOVE(from, to, t) \
+    (profPhases[from].accum -= (t), profPhases[to].accum += (t))
+#define PROF_FRAME_END() profFrameEnd()
+#else
+#define PROF_BEGIN(p)   ((void)0)
+#define PROF_END(p)     ((void)0)
+#define PROF_MOVE(from, to, t) ((void)0)
+#define PROF_FRAME_END() ((void)0)
+#endif
+
+/* Close the current frame: commit every phase's accumulated time */
+void profFrameEnd(void);
+
+/* Summary over the last PROF_WINDOW frames (or fewer, early on) */
+void profSummarize(profPhase p, profSummary *out);
+
+const char *profPhaseName(profPhase p);
+
+/* Frames recorded since start */
+u32 profFrames(void);
+
+/* Print every phase's summary and histogram to stdout (TTY) */
+void profDump(void);
+
+#endif
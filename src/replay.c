@@ -0,0 +1,333 @@
+/*
+ * Input record and replay with per-frame timing (see replay.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "replay.h"
+#include "timer.h"
+
+static replayMode   mode = REPLAY_OFF;
+
+/* Recording: encoded records waiting to be written */
+static FILE        *out;
+static const char  *out_path;
+static u8           buf[REPLAY_BUFFER * REPLAY_RECORD_SIZE];
+static u32          buffered;
+static u32          written;            /* records, header excluded */
+static u32          write_errors;
+
+/* Replaying */
+static replayTrace  trace;
+static const char  *csv_path;
+static u32          cursor;             /* next record */
+static u32         *times;              /* per frame: ticks, wait ticks */
+static u64          rec_elapsed;        /* recorded ticks before this frame */
+static u64          t0;
+
+static u32          frame;
+static u64          frame_start;
+
+static void put16(u8 *p, u32 v)
+{
+    p[0] = (u8)(v >> 8);
+    p[1] = (u8)v;
+}
+
+static void put32(u8 *p, u32 v)
+{
+    p[0] = (u8)(v >> 24);
+    p[1] = (u8)(v >> 16);
+    p[2] = (u8)(v >> 8);
+    p[3] = (u8)v;
+}
+
+static u32 get16(const u8 *p)
+{
+    return (u32)p[0] << 8 | p[1];
+}
+
+static u32 get32(const u8 *p)
+{
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+/* Frame times are kept in u32 ticks: 53 s at 79.8 MHz */
+static u32 clampTicks(u64 t)
+{
+    return t > 0xffffffffULL ? 0xffffffffU : (u32)t;
+}
+
+s32 replayTraceLoad(const char *path, replayTrace *t)
+{
+    FILE *f;
+    long size;
+    u8 *raw = NULL;
+    u32 i;
+
+    memset(t, 0, sizeof(*t));
+    if ((f = fopen(path, "rb")) == NULL)
+        return -1;
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < REPLAY_HEADER_SIZE ||
+        fseek(f, 0, SEEK_SET) != 0 || (raw = (u8 *)malloc(size)) == NULL ||
+        fread(raw, 1, size, f) != (size_t)size ||
+        get32(raw) != REPLAY_MAGIC || get32(raw + 4) != REPLAY_VERSION) {
+        free(raw);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    t->width    = get32(raw + 8);
+    t->height   = get32(raw + 12);
+    t->buffers  = get32(raw + 16);
+    t->timebase = (u64)get32(raw + 24) << 32 | get32(raw + 28);
+    /* A trace cut short by a crash keeps its whole records */
+    t->count    = (u32)((size - REPLAY_HEADER_SIZE) / REPLAY_RECORD_SIZE);
+    t->records  = (replayRecord *)malloc((t->count ? t->count : 1) * sizeof(replayRecord));
+    if (!t->records || !t->timebase) {
+        free(t->records);
+        free(raw);
+        memset(t, 0, sizeof(*t));
+        return -1;
+    }
+
+    for (i = 0; i < t->count; i++) {
+        const u8 *p = raw + REPLAY_HEADER_SIZE + i * REPLAY_RECORD_SIZE;
+        replayRecord *r = &t->records[i];
+
+        r->kind     = p[0];
+        r->pad      = p[1];
+        r->pressed  = (u16)get16(p + 2);
+        r->released = (u16)get16(p + 4);
+        r->buttons  = (u16)get16(p + 6);
+        r->v0       = get32(p + 8);
+        r->v1       = get32(p + 12);
+        if (r->kind == REPLAY_FRAME)
+            t->frames++;
+    }
+    free(raw);
+    return 0;
+}
+
+void replayTraceFree(replayTrace *t)
+{
+    free(t->records);
+    memset(t, 0, sizeof(*t));
+}
+
+/* ---------- recording ---------- */
+
+static void flush(void)
+{
+    if (buffered && fwrite(buf, REPLAY_RECORD_SIZE, buffered, out) != buffered)
+        write_errors++;
+    written += buffered;
+    buffered = 0;
+}
+
+static void append(u32 kind, u32 pad, u32 pressed, u32 released, u32 buttons, u32 v0, u32 v1)
+{
+    u8 *p;
+
+    if (mode != REPLAY_RECORD)
+        return;
+    /* The write lands in whichever frame fills the buffer: every ~REPLAY_BUFFER records */
+    if (buffered == REPLAY_BUFFER)
+        flush();
+
+    p = buf + buffered++ * REPLAY_RECORD_SIZE;
+    p[0] = (u8)kind;
+    p[1] = (u8)pad;
+    put16(p + 2, pressed);
+    put16(p + 4, released);
+    put16(p + 6, buttons);
+    put32(p + 8, v0);
+    put32(p + 12, v1);
+}
+
+void replayPad(const inputEvent *ev)
+{
+    append(REPLAY_PAD, ev->pad, ev->pressed, ev->released, ev->buttons, 0, 0);
+}
+
+void replaySysutil(u64 status)
+{
+    append(REPLAY_SYSUTIL, 0, 0, 0, 0, (u32)status, 0);
+}
+
+void replaySpe(u32 flags)
+{
+    append(REPLAY_SPE, 0, 0, 0, 0, flags, 0);
+}
+
+/* ---------- session ---------- */
+
+s32 replayStart(replayMode m, const char *trace_path, const char *csv,
+                u32 width, u32 height, u32 buffers)
+{
+    u8 header[REPLAY_HEADER_SIZE];
+    u64 tb = sysGetTimebaseFrequency();
+
+    mode   = REPLAY_OFF;
+    frame  = 0;
+    cursor = 0;
+    rec_elapsed = 0;
+
+    if (m == REPLAY_RECORD) {
+        if ((out = fopen(trace_path, "wb")) == NULL)
+            return -1;
+        memset(header, 0, sizeof(header));
+        put32(header, REPLAY_MAGIC);
+        put32(header + 4, REPLAY_VERSION);
+        put32(header + 8, width);
+        put32(header + 12, height);
+        put32(header + 16, buffers);
+        put32(header + 24, (u32)(tb >> 32));
+        put32(header + 28, (u32)tb);
+        write_errors = fwrite(header, 1, sizeof(header), out) != sizeof(header);
+        out_path = trace_path;
+        buffered = 0;
+        written  = 0;
+    } else if (m == REPLAY_FAST || m == REPLAY_PACED) {
+        if (replayTraceLoad(trace_path, &trace) != 0)
+            return -1;
+        times = (u32 *)calloc(trace.frames ? trace.frames : 1, 2 * sizeof(u32));
+        if (!times) {
+            replayTraceFree(&trace);
+            return -1;
+        }
+        if (trace.width != width || trace.height != height || trace.buffers != buffers)
+            printf("replay: trace is %ux%u/%u buffers, this run %ux%u/%u: times won't compare\n",
+                   trace.width, trace.height, trace.buffers, width, height, buffers);
+        csv_path = csv;
+    } else {
+        return 0;
+    }
+
+    mode = m;
+    return 0;
+}
+
+replayMode replayGetMode(void)
+{
+    return mode;
+}
+
+int replayPlaying(void)
+{
+    return mode == REPLAY_FAST || mode == REPLAY_PACED;
+}
+
+u32 replayNext(replayRecord *r)
+{
+    if (!replayPlaying() || cursor >= trace.count || trace.records[cursor].kind == REPLAY_FRAME)
+        return 0;
+    *r = trace.records[cursor++];
+    return 1;
+}
+
+void replayFrameBegin(void)
+{
+    u64 now = timerNow();
+
+    if (mode == REPLAY_PACED) {
+        u64 target;
+
+        if (frame == 0)
+            t0 = now;
+        target = t0 + (u64)((double)rec_elapsed * sysGetTimebaseFrequency() / trace.timebase);
+
+        /* Sleep off all but the last millisecond, then spin */
+        while ((now = timerNow()) < target) {
+            double left_us = timerToUsec(target - now);
+
+            if (left_us > 2000.0)
+                usleep((useconds_t)(left_us - 1000.0));
+        }
+    }
+    frame_start = now;
+}
+
+void replayFrameEnd(u64 wait)
+{
+    u32 ticks = clampTicks(timerNow() - frame_start);
+
+    if (mode == REPLAY_RECORD) {
+        append(REPLAY_FRAME, 0, 0, 0, 0, ticks, clampTicks(wait));
+    } else if (replayPlaying()) {
+        /* Events the loop didn't take belong to this frame all the same */
+        while (cursor < trace.count && trace.records[cursor].kind != REPLAY_FRAME)
+            cursor++;
+        if (cursor == trace.count)
+            return;
+        times[2 * frame]     = ticks;
+        times[2 * frame + 1] = clampTicks(wait);
+        rec_elapsed += trace.records[cursor].v0;
+        cursor++;
+    } else {
+        return;
+    }
+    frame++;
+}
+
+int replayDone(void)
+{
+    return replayPlaying() && cursor >= trace.count;
+}
+
+static void writeCsv(void)
+{
+    double tb = (double)trace.timebase;
+    double sum = 0.0, rec_sum = 0.0;
+    FILE *f;
+    u32 i, r = 0;
+
+    if ((f = fopen(csv_path, "w")) == NULL) {
+        printf("replay: can't write %s\n", csv_path);
+        return;
+    }
+    fprintf(f, "frame,frame_us,wait_us,busy_us,recorded_us,recorded_wait_us\n");
+    for (i = 0; i < frame; i++) {
+        double us      = timerToUsec(times[2 * i]);
+        double wait_us = timerToUsec(times[2 * i + 1]);
+        double rec_us, rec_wait_us;
+
+        while (trace.records[r].kind != REPLAY_FRAME)
+            r++;
+        rec_us      = trace.records[r].v0 * 1e6 / tb;
+        rec_wait_us = trace.records[r].v1 * 1e6 / tb;
+        r++;
+
+        fprintf(f, "%u,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                i, us, wait_us, us - wait_us, rec_us, rec_wait_us);
+        sum     += us;
+        rec_sum += rec_us;
+    }
+    fclose(f);
+
+    printf("replay: %s %u/%u frames, avg %.1f us (recorded %.1f us), times in %s\n",
+           mode == REPLAY_PACED ? "paced" : "fast", frame, trace.frames,
+           frame ? sum / frame : 0.0, frame ? rec_sum / frame : 0.0, csv_path);
+}
+
+void replayStop(void)
+{
+    if (mode == REPLAY_RECORD) {
+        flush();
+        if (fclose(out) != 0)
+            write_errors++;
+        out = NULL;
+        printf("replay: recorded %u frames (%u records) to %s%s\n", frame, written,
+               out_path, write_errors ? ", write errors" : "");
+    } else if (replayPlaying()) {
+        writeCsv();
+        free(times);
+        times = NULL;
+        replayTraceFree(&trace);
+    }
+    mode = REPLAY_OFF;
+}
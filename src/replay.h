@@ -0,0 +1,117 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+/*
+ * Record and replay of the main loop's inputs, for comparable timing runs.
+ *
+ * Recording logs, frame by frame, every pad transition the loop handles,
+ * every sysutil event, the frame on which the SPU bring-up results were
+ * picked up, and the frame's time (loop body, and the part of it spent
+ * waiting in swapAcquire) to a compact binary trace.
+ *
+ * Replaying loads a trace and hands its events back to the loop on the
+ * frame they were recorded on, in the same order, while live pad input is
+ * ignored. Frames run back to back (REPLAY_FAST) or start when they
+ * started in the recording (REPLAY_PACED). Each frame's time is kept in
+ * memory and written as CSV when the replay stops, one line per frame:
+ *
+ *   frame,frame_us,wait_us,busy_us,recorded_us,recorded_wait_us
+ *
+ * busy_us is frame_us - wait_us: the PPU's own work. Two builds replaying
+ * one trace get CSVs that compare line for line (host/hostreplay cmp).
+ *
+ * Trace format, big-endian: a 32-byte header (REPLAY_MAGIC, version,
+ * width, height, buffers, 0, time-base frequency as u64) then 16-byte
+ * records. Records carry no frame number: a frame is every record up to
+ * and including its REPLAY_FRAME record.
+ */
+#include <ppu-types.h>
+
+#include "input.h"
+
+#define REPLAY_MAGIC        0x50335250  /* "P3RP" */
+#define REPLAY_VERSION      1
+#define REPLAY_HEADER_SIZE  32
+#define REPLAY_RECORD_SIZE  16
+#define REPLAY_BUFFER       16384       /* records held before a write */
+
+typedef enum {
+    REPLAY_OFF = 0,
+    REPLAY_RECORD,
+    REPLAY_FAST,            /* replay, frames back to back */
+    REPLAY_PACED            /* replay, frames started at the recorded times */
+} replayMode;
+
+typedef enum {
+    REPLAY_PAD = 1,         /* a pad transition (inputEvent without its time) */
+    REPLAY_SYSUTIL,         /* v0: sysutil status */
+    REPLAY_SPE,             /* bring-up picked up; v0: REPLAY_SPE_* */
+    REPLAY_FRAME            /* end of frame; v0: frame ticks, v1: flip-wait ticks */
+} replayKind;
+
+#define REPLAY_SPE_OK       (1 << 0)    /* spe_ok */
+#define REPLAY_SPE_RASTER   (1 << 1)    /* spu_raster_ok */
+
+typedef struct {
+    u8  kind;
+    u8  pad;
+    u16 pressed;
+    u16 released;
+    u16 buttons;
+    u32 v0;
+    u32 v1;
+} replayRecord;
+
+typedef struct {
+    u32           width;
+    u32           height;
+    u32           buffers;
+    u64           timebase;     /* ticks per second of the frame times */
+    u32           count;
+    u32           frames;       /* REPLAY_FRAME records */
+    replayRecord *records;
+} replayTrace;
+
+/* Whole trace into memory. Returns 0, or -1 if missing, short or not a trace. */
+s32 replayTraceLoad(const char *path, replayTrace *t);
+
+void replayTraceFree(replayTrace *t);
+
+/*
+ * Start recording to / replaying from 'trace'. 'csv' is where a replay
+ * writes its frame times; width, height and buffers describe this run
+ * and go in the header when recording (a replay only warns if they
+ * differ). Returns 0, or -1 if the trace can't be opened or loaded, in
+ * which case the run goes on with replay off.
+ */
+s32 replayStart(replayMode mode, const char *trace, const char *csv,
+                u32 width, u32 height, u32 buffers);
+
+replayMode replayGetMode(void);
+
+/* Replaying: the loop takes its events from replayNext(), not from live input */
+int replayPlaying(void);
+
+/* Log an event the loop handled this frame (no-ops unless recording) */
+void replayPad(const inputEvent *ev);
+void replaySysutil(u64 status);
+void replaySpe(u32 flags);
+
+/* Replaying: next recorded event of the current frame; returns 0 when there are no more */
+u32 replayNext(replayRecord *r);
+
+/*
+ * Bracket one iteration of the main loop. Begin waits for the recorded
+ * start time when REPLAY_PACED; End logs or keeps the frame's time,
+ * 'wait' being the ticks spent in swapAcquire.
+ */
+void replayFrameBegin(void);
+void replayFrameEnd(u64 wait);
+
+/* Replaying and every recorded frame has run */
+int replayDone(void);
+
+/* Write out the rest of the trace, or the CSV; prints a summary */
+void replayStop(void);
+
+#endif
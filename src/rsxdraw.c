@@ -0,0 +1,210 @@
+/*
+ * RSX clears and glyph-atlas transfers.
+ */
+
+#include <string.h>
+
+#include <ppu_intrinsics.h>
+#include <rsx/gcm_sys.h>
+
+#include "rsxdraw.h"
+
+#define ATLAS_COLS      16
+#define ATLAS_ROWS      6   /* 16 x 6 cells >= 95 glyphs */
+
+/*
+ * rsxFinish() returns as soon as the reference register holds the value
+ * it is given, so each eviction waits on a new one. The top bit keeps
+ * them apart from the small values main() and the benchmarks pass.
+ */
+#define FENCE_BASE      0x80000000u
+
+typedef struct {
+    u32  scale;
+    u32  color;
+    u32  bg;
+    u32 *ptr;
+    u32  offset;
+    u32  pitch;
+    u32  used;      /* atlas_clock at the last lookup */
+} rsxAtlas;
+
+static gcmContextData *ctx;
+static u32  max_w, max_h;
+static u32 *depth_ptr;
+static u32  depth_offset, depth_pitch;
+static glyphTarget bound;           /* colour surface currently bound */
+
+static rsxAtlas atlases[RSXDRAW_ATLAS_CACHE];
+static u32      atlases_used;
+static u32      atlas_clock;
+static u32      fence;
+
+s32 rsxDrawInit(gcmContextData *context, u32 max_width, u32 max_height)
+{
+    ctx   = context;
+    max_w = max_width;
+    max_h = max_height;
+
+    depth_pitch = max_width * sizeof(u16);
+    depth_ptr   = (u32 *)rsxMemalign(64, depth_pitch * max_height);
+    if (!depth_ptr)
+        return -1;
+    return rsxAddressToOffset(depth_ptr, &depth_offset);
+}
+
+/* Bind 't' as colour target 0 (surface setup is skipped if already bound) */
+static void bindSurface(const glyphTarget *t)
+{
+    gcmSurface sf;
+
+    if (bound.ptr == t->ptr && bound.offset == t->offset && bound.pitch == t->pitch &&
+        bound.width == t->width && bound.height == t->height)
+        return;
+
+    memset(&sf, 0, sizeof(sf));
+    sf.colorFormat      = GCM_TF_COLOR_X8R8G8B8;
+    sf.colorTarget      = GCM_TF_TARGET_0;
+    sf.colorLocation[0] = GCM_LOCATION_RSX;
+    sf.colorOffset[0]   = t->offset;
+    sf.colorPitch[0]    = t->pitch;
+    sf.colorLocation[1] = GCM_LOCATION_RSX;
+    sf.colorLocation[2] = GCM_LOCATION_RSX;
+    sf.colorLocation[3] = GCM_LOCATION_RSX;
+    sf.colorPitch[1]    = 64;
+    sf.colorPitch[2]    = 64;
+    sf.colorPitch[3]    = 64;
+    sf.depthFormat      = GCM_TF_ZETA_Z16;
+    sf.depthLocation    = GCM_LOCATION_RSX;
+    sf.depthOffset      = depth_offset;
+    sf.depthPitch       = depth_pitch;
+    sf.type             = GCM_TF_TYPE_LINEAR;
+    sf.antiAlias        = GCM_TF_CENTER_1;
+    sf.width            = t->width;
+    sf.height           = t->height;
+    sf.x                = 0;
+    sf.y                = 0;
+    rsxSetSurface(ctx, &sf);
+
+    bound = *t;
+}
+
+static void rsxFill(const glyphTarget *t, const textRect *r, u32 color)
+{
+    if (!r->w || !r->h || t->width > max_w || t->height > max_h)
+        return;
+
+    bindSurface(t);
+    rsxSetScissor(ctx, r->x, r->y, r->w, r->h);
+    rsxSetClearColor(ctx, color);
+    rsxSetColorMask(ctx, GCM_COLOR_MASK_R | GCM_COLOR_MASK_G |
+                         GCM_COLOR_MASK_B | GCM_COLOR_MASK_A);
+    rsxClearSurface(ctx, GCM_CLEAR_R | GCM_CLEAR_G | GCM_CLEAR_B | GCM_CLEAR_A);
+}
+
+/* Render the atlas for (scale, colour, bg) once, with the PPU, into RSX memory */
+static const rsxAtlas *atlasFor(u32 scale, u32 color, u32 bg)
+{
+    glyphTarget at;
+    rsxAtlas *a;
+    u32 cell = FONT_W * scale;
+    u32 i, n;
+
+    atlas_clock++;
+    for (i = 0; i < atlases_used; i++) {
+        a = &atlases[i];
+        if (a->ptr && a->scale == scale && a->color == color && a->bg == bg) {
+            a->used = atlas_clock;
+            return a;
+        }
+    }
+
+    /* A slot whose allocation failed is free again */
+    for (i = 0; i < atlases_used && atlases[i].ptr; i++)
+        ;
+    if (i < atlases_used) {
+        a = &atlases[i];
+    } else if (atlases_used < RSXDRAW_ATLAS_CACHE) {
+        a = &atlases[atlases_used++];
+    } else {
+        /* Evict the least recently used, once the RSX is done reading it */
+        a = &atlases[0];
+        for (i = 1; i < atlases_used; i++)
+            if (atlas_clock - atlases[i].used > atlas_clock - a->used)
+                a = &atlases[i];
+        rsxFinish(ctx, FENCE_BASE | (++fence & ~FENCE_BASE));
+        rsxFree(a->ptr);
+        a->ptr = NULL;
+    }
+
+    a->scale = scale;
+    a->color = color;
+    a->bg    = bg;
+    a->used  = atlas_clock;
+    a->pitch = ATLAS_COLS * cell * sizeof(u32);
+    a->ptr   = (u32 *)rsxMemalign(64, a->pitch * ATLAS_ROWS * cell);
+    if (!a->ptr) {
+        a->scale = 0;
+        return NULL;
+    }
+    rsxAddressToOffset(a->ptr, &a->offset);
+
+    at.ptr    = a->ptr;
+    at.width  = ATLAS_COLS * cell;
+    at.height = ATLAS_ROWS * cell;
+    at.pitch  = a->pitch;
+    at.offset = a->offset;
+
+    n = at.pitch / sizeof(u32) * at.height;
+    for (i = 0; i < n; i++)
+        a->ptr[i] = bg;
+    for (i = 0; i <= FONT_LAST - FONT_FIRST; i++)
+        glyphDrawChar(&at, (char)(FONT_FIRST + i),
+                      (i % ATLAS_COLS) * cell, (i / ATLAS_COLS) * cell, color, scale);
+
+    /* Make the PPU stores visible before the RSX reads the atlas */
+    __sync();
+    return a;
+}
+
+static void rsxDraw(const glyphTarget *t, const char *str, u32 x, u32 y,
+                    u32 color, u32 scale, u32 bg)
+{
+    const rsxAtlas *a;
+    u32 cell = FONT_W * scale;
+    u32 cx = x;
+
+    if (scale < 1 || scale > GLYPH_MAX_SCALE)
+        return;
+    a = atlasFor(scale, color, bg);
+    if (!a)
+        return;
+
+    for (; *str; str++) {
+        char c = *str;
+        u32 g, w, h;
+
+        if (c == '\n') {
+            cx = x;
+            y += FONT_H * scale + 2;
+            continue;
+        }
+        if (c < FONT_FIRST || c > FONT_LAST)
+            c = '?';
+        g = (u32)(c - FONT_FIRST);
+
+        /* Clip the cell once; off-screen glyphs issue no command */
+        if (cx < t->width && y < t->height) {
+            w = t->width  - cx < cell ? t->width  - cx : cell;
+            h = t->height - y  < cell ? t->height - y  : cell;
+            rsxSetTransferImage(ctx, GCM_TRANSFER_LOCAL_TO_LOCAL,
+                                t->offset, t->pitch, cx, y,
+                                a->offset, a->pitch,
+                                (g % ATLAS_COLS) * cell, (g / ATLAS_COLS) * cell,
+                                w, h, sizeof(u32));
+        }
+        cx += cell;
+    }
+}
+
+const textBackend textBackendRsx = { "rsx", rsxFill, rsxDraw, NULL };
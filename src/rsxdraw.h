@@ -0,0 +1,35 @@
+#ifndef __RSXDRAW_H__
+#define __RSXDRAW_H__
+
+/*
+ * RSX rendering back end for the text layer.
+ *
+ * Clears are RSX surface clears (scissored to the dirty rectangle) and
+ * strings are RSX image transfers, one per glyph, from a glyph atlas kept
+ * in RSX local memory. The atlas is rendered once per (scale, colour,
+ * background) on first use, so glyphs are blitted as opaque cells.
+ * Everything is queued on the GCM context; the PPU never touches the
+ * framebuffer.
+ */
+#include <ppu-types.h>
+#include <rsx/rsx.h>
+
+#include "textlayer.h"
+
+/*
+ * (scale, colour, background) atlases. The demo screen uses 9 (scale,
+ * colour) pairs on one background, the profiler overlay included; an
+ * eviction waits for the RSX to go idle, so the cache must hold them all.
+ */
+#define RSXDRAW_ATLAS_CACHE 16
+
+/*
+ * Allocate the depth buffer the colour surface is bound with. Targets
+ * drawn through the back end must not exceed max_width x max_height.
+ */
+s32 rsxDrawInit(gcmContextData *context, u32 max_width, u32 max_height);
+
+/* Back end to hand to textLayerSetBackend() once rsxDrawInit() succeeded */
+extern const textBackend textBackendRsx;
+
+#endif
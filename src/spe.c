@@ -0,0 +1,42 @@
+/*
+ * One-shot SPU thread helper: create group -> init thread -> start -> join.
+ */
+
+#include <string.h>
+
+#include "spe.h"
+
+s32 speRunOnce(sysSpuImage *image, u64 arg0, u64 arg1, u64 arg2, u64 arg3)
+{
+    sysSpuThreadGroupAttribute grpattr;
+    sysSpuThreadAttribute thattr;
+    sysSpuThreadArgument arg;
+    u32 group_id, thread_id;
+    u32 cause, status;
+    s32 ret;
+
+    memset(&grpattr, 0, sizeof(grpattr));
+    grpattr.nameSize = 7;
+    grpattr.nameAddress = (u32)(uintptr_t)"spugrp";
+    ret = sysSpuThreadGroupCreate(&group_id, 1, 100, &grpattr);
+    if (ret)
+        return ret;
+
+    memset(&thattr, 0, sizeof(thattr));
+    thattr.nameAddress = (u32)(uintptr_t)"sputhr";
+    thattr.nameSize = 7;
+    thattr.attribute = SPU_THREAD_ATTR_NONE;
+
+    arg.arg0 = arg0;
+    arg.arg1 = arg1;
+    arg.arg2 = arg2;
+    arg.arg3 = arg3;
+    ret = sysSpuThreadInitialize(&thread_id, group_id, 0, image, &thattr, &arg);
+    if (ret == 0)
+        ret = sysSpuThreadGroupStart(group_id);
+    if (ret == 0)
+        ret = sysSpuThreadGroupJoin(group_id, &cause, &status);
+
+    sysSpuThreadGroupDestroy(group_id);
+    return ret;
+}
@@ -0,0 +1,13 @@
+#ifndef __SPE_H__
+#define __SPE_H__
+
+#include <ppu-types.h>
+#include <sys/spu.h>
+
+/*
+ * Run the SPU image once on a single-thread group and block until it
+ * exits. Returns the first failing syscall's error code, or 0.
+ */
+s32 speRunOnce(sysSpuImage *image, u64 arg0, u64 arg1, u64 arg2, u64 arg3);
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * SPU overlay table (embedded blobs -> DMA-able copies).
+ */
+
+#include <malloc.h>
+#include <string.h>
+
+#include "spu_overlay.h"
+
+extern const unsigned int spu_ovl_tiles[];
+extern const unsigned int spu_ovl_tiles_size;
+extern const unsigned int spu_ovl_soa[];
+extern const unsigned int spu_ovl_soa_size;
+
+static const struct {
+    const unsigned int *data;
+    const unsigned int *size;
+} blobs[VECMATH_OVERLAYS] = {
+    [VECMATH_OVERLAY_TILES] = { spu_ovl_tiles, &spu_ovl_tiles_size },
+    [VECMATH_OVERLAY_SOA]   = { spu_ovl_soa,   &spu_ovl_soa_size },
+};
+
+static vecmath_overlay_t table[VECMATH_OVERLAYS] __attribute__((aligned(128)));
+static u32 built;
+
+const vecmath_overlay_t *spuOverlayTable(void)
+{
+    u32 i;
+
+    if (built)
+        return table;
+
+    /* The SPU rounds each transfer up to 16 bytes: pad the copies too */
+    for (i = 0; i < VECMATH_OVERLAYS; i++) {
+        u32 size = *blobs[i].size;
+        void *p  = memalign(128, (size + 127) & ~127);
+
+        if (!p)
+            continue;
+        memset(p, 0, (size + 127) & ~127);
+        memcpy(p, blobs[i].data, size);
+        table[i].ea   = (u32)(uintptr_t)p;
+        table[i].size = size;
+    }
+    built = 1;
+    return table;
+}
@@ -0,0 +1,21 @@
+#ifndef __SPU_OVERLAY_H__
+#define __SPU_OVERLAY_H__
+
+/*
+ * SPU kernel overlays. The TILES and SOA kernels are linked as separate
+ * blobs (spu/overlay.ld) embedded next to spu_bin; resident workers DMA
+ * one into a reserved local-store region when a job for it arrives, so
+ * adding or switching kernels never reloads the SPU image.
+ */
+#include <ppu-types.h>
+
+#include "vecmath.h"
+
+/*
+ * Table of VECMATH_OVERLAYS entries handed to every worker (arg2). Built
+ * on first use by copying each blob into 128-byte aligned memory that is
+ * kept for the life of the process; an entry whose copy failed has size 0.
+ */
+const vecmath_overlay_t *spuOverlayTable(void);
+
+#endif
@@ -0,0 +1,374 @@
+/*
+ * Persistent SPU worker runtime (mailbox job dispatch).
+ */
+
+#include <string.h>
+
+#include "spu_overlay.h"
+#include "spu_worker.h"
+#include "timer.h"
+
+s32 spuWorkerStart(spuWorker *w, sysSpuImage *image, u32 nthreads)
+{
+    sysSpuThreadGroupAttribute grpattr;
+    sysSpuThreadAttribute thattr;
+    sysSpuThreadArgument arg;
+    sys_event_queue_attr_t qattr;
+    u32 i, connected = 0;
+    s32 ret;
+
+    memset(w, 0, sizeof(*w));
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > SPU_WORKER_MAX)
+        nthreads = SPU_WORKER_MAX;
+
+    memset(&qattr, 0, sizeof(qattr));
+    qattr.attr_protocol = SYS_EVENT_QUEUE_PRIO;
+    qattr.type = SYS_EVENT_QUEUE_PPU;
+    strcpy(qattr.name, "spuwrk");
+    ret = sysEventQueueCreate(&w->queue, &qattr, SYS_EVENT_QUEUE_KEY_LOCAL,
+                              4 * SPU_WORKER_MAX);
+    if (ret)
+        return ret;
+
+    memset(&grpattr, 0, sizeof(grpattr));
+    grpattr.nameSize = 7;
+    grpattr.nameAddress = (u32)(uintptr_t)"spuwrk";
+    ret = sysSpuThreadGroupCreate(&w->group_id, nthreads, 100, &grpattr);
+    if (ret)
+        goto fail_queue;
+
+    memset(&thattr, 0, sizeof(thattr));
+    thattr.nameAddress = (u32)(uintptr_t)"spuwrk";
+    thattr.nameSize = 7;
+    thattr.attribute = SPU_THREAD_ATTR_NONE;
+
+    /* arg0/arg1 locate this thread's status quadword, arg2 the overlays */
+    arg.arg0 = (u64)(uintptr_t)w->status;
+    arg.arg2 = (u64)(uintptr_t)spuOverlayTable();
+    arg.arg3 = VECMATH_MODE_WORKER;
+
+    for (i = 0; i < nthreads; i++) {
+        arg.arg1 = i;
+        ret = sysSpuThreadInitialize(&w->thread_id[i], w->group_id, i, image, &thattr, &arg);
+        if (ret)
+            goto fail_group;
+
+        ret = sysSpuThreadConnectEvent(w->thread_id[i], w->queue,
+                                       SPU_THREAD_EVENT_USER, VECMATH_EVENT_PORT);
+        if (ret)
+            goto fail_group;
+        connected++;
+    }
+    w->count = nthreads;
+
+    ret = sysSpuThreadGroupStart(w->group_id);
+    if (ret)
+        goto fail_group;
+
+    w->running = 1;
+    return 0;
+
+fail_group:
+    for (i = 0; i < connected; i++)
+        sysSpuThreadDisconnectEvent(w->thread_id[i], SPU_THREAD_EVENT_USER, VECMATH_EVENT_PORT);
+    sysSpuThreadGroupDestroy(w->group_id);
+fail_queue:
+    sysEventQueueDestroy(w->queue, 0);
+    w->count = 0;
+    return ret;
+}
+
+s32 spuWorkerSubmit(spuWorker *w, u32 index, u32 kernel, void *ea, u32 size, u32 chunk)
+{
+    u32 thread, cmd;
+    s32 ret;
+
+    if (!w->running || index >= w->count || w->pending[index])
+        return -1;
+
+    cmd = VECMATH_JOB_CMD(kernel, chunk);
+    if (w->notify == SPU_WORKER_NOTIFY_STATUS)
+        cmd |= VECMATH_JOB_STATUS;
+
+    thread = w->thread_id[index];
+    ret = sysSpuThreadWriteMb(thread, cmd);
+    if (ret == 0)
+        ret = sysSpuThreadWriteMb(thread, (u32)(uintptr_t)ea);
+    if (ret == 0)
+        ret = sysSpuThreadWriteMb(thread, size);
+    if (ret == 0) {
+        w->pending[index]   = 1;
+        w->completed[index] = 0;
+        w->seq[index]++;
+    }
+    return ret;
+}
+
+s32 spuWorkerSetNotify(spuWorker *w, u32 notify)
+{
+    u32 i;
+
+    for (i = 0; i < w->count; i++) {
+        if (w->pending[i])
+            return -1;
+    }
+    w->notify = notify;
+    return 0;
+}
+
+/* Route one completion event to the worker whose thread raised it */
+static s32 receiveEvent(spuWorker *w, u64 timeout_usec)
+{
+    sys_event_t ev;
+    u32 i;
+    s32 ret;
+
+    /* data_1 = source thread, data_2 = (port << 32) | kernel, data_3 = size */
+    ret = sysEventQueueReceive(w->queue, &ev, timeout_usec);
+    if (ret)
+        return ret;
+
+    for (i = 0; i < w->count; i++) {
+        if (w->thread_id[i] == (u32)ev.data_1) {
+            w->completed[i] = 1;
+            w->result[i]    = (u32)ev.data_3;
+            break;
+        }
+    }
+    return 0;
+}
+
+/* Status mode: the job is done once the SPU's count catches up with ours */
+static u32 statusDone(spuWorker *w, u32 index)
+{
+    volatile vecmath_status_t *st = &w->status[index];
+
+    if (st->seq != w->seq[index])
+        return 0;
+
+    /* Keep the caller's loads of the job's results behind the status load */
+    __lwsync();
+    w->completed[index] = 1;
+    w->result[index]    = st->size;
+    return 1;
+}
+
+static void retire(spuWorker *w, u32 index, u32 *result)
+{
+    w->pending[index] = 0;
+    if (result)
+        *result = w->result[index];
+}
+
+/*
+ * Wait until a pending job in 'mask' completes and store its worker in
+ * 'index'. Event mode blocks in the queue (the timeout applies to each
+ * receive); status mode spins on the status line against a deadline.
+ */
+static s32 waitMask(spuWorker *w, u32 mask, u64 timeout_usec, u32 *index)
+{
+    u64 deadline = 0;
+    u32 i;
+    s32 ret;
+
+    if (timeout_usec && w->notify == SPU_WORKER_NOTIFY_STATUS)
+        deadline = timerNow() + timeout_usec * sysGetTimebaseFrequency() / 1000000;
+
+    for (;;) {
+        for (i = 0; i < w->count; i++) {
+            if (!(mask & (1 << i)) || !w->pending[i])
+                continue;
+            if (w->completed[i] || (w->notify == SPU_WORKER_NOTIFY_STATUS && statusDone(w, i))) {
+                *index = i;
+                return 0;
+            }
+        }
+
+        if (w->notify == SPU_WORKER_NOTIFY_EVENT) {
+            ret = receiveEvent(w, timeout_usec);
+            if (ret)
+                return ret;
+        } else if (deadline && timerNow() >= deadline) {
+            return SPU_WORKER_BUSY;
+        }
+    }
+}
+
+s32 spuWorkerPoll(spuWorker *w, u32 index, u32 *result)
+{
+    if (index >= w->count || !w->pending[index])
+        return -1;
+
+    if (!w->completed[index]) {
+        if (w->notify == SPU_WORKER_NOTIFY_STATUS)
+            statusDone(w, index);
+        else
+            receiveEvent(w, 1);     /* may complete another worker's job */
+    }
+    if (!w->completed[index])
+        return SPU_WORKER_BUSY;
+
+    retire(w, index, result);
+    return 0;
+}
+
+s32 spuWorkerWait(spuWorker *w, u32 index, u64 timeout_usec, u32 *result)
+{
+    s32 ret;
+
+    if (index >= w->count || !w->pending[index])
+        return -1;
+
+    ret = waitMask(w, 1 << index, timeout_usec, &index);
+    if (ret)
+        return ret;
+
+    retire(w, index, result);
+    return 0;
+}
+
+s32 spuWorkerWaitAny(spuWorker *w, u32 mask, u64 timeout_usec, u32 *index, u32 *result)
+{
+    u32 i, pending = 0, which;
+    s32 ret;
+
+    if (!mask)
+        mask = (1 << SPU_WORKER_MAX) - 1;
+    for (i = 0; i < w->count; i++) {
+        if (w->pending[i])
+            pending |= 1 << i;
+    }
+    if (!(mask & pending))
+        return -1;
+
+    ret = waitMask(w, mask & pending, timeout_usec, &which);
+    if (ret)
+        return ret;
+
+    retire(w, which, result);
+    if (index)
+        *index = which;
+    return 0;
+}
+
+s32 spuWorkerReserve(spuWorker *w, u32 index, u32 reserve)
+{
+    u32 bit = 1 << index;
+
+    if (index >= w->count)
+        return -1;
+    if (reserve && !(spuWorkerSharedMask(w) & ~bit))
+        return -1;
+    w->reserved = reserve ? w->reserved | bit : w->reserved & ~bit;
+    return 0;
+}
+
+u32 spuWorkerSharedMask(const spuWorker *w)
+{
+    return ((1 << w->count) - 1) & ~w->reserved;
+}
+
+s32 spuWorkerRunQueue(spuWorker *w, vecmath_queue_t *queue, vecmath_vec_t *vecs,
+                      u32 count, u32 grain, u32 chunk)
+{
+    u32 shared = spuWorkerSharedMask(w);
+    u32 i, done, total = 0;
+    s32 ret = 0;
+
+    queue->next    = 0;
+    queue->count   = count;
+    queue->grain   = grain ? grain : VECMATH_CHUNK_DEFAULT;
+    queue->chunk   = chunk;
+    queue->ea_vecs = (u32)(uintptr_t)vecs;
+
+    for (i = 0; i < w->count && ret == 0; i++)
+        if (shared & (1 << i))
+            ret = spuWorkerSubmit(w, i, VECMATH_KERNEL_QUEUE, queue, 0, 0);
+
+    /* Always collect every submitted job, even if a later submit failed */
+    for (i = 0; i < w->count; i++) {
+        if ((shared & (1 << i)) && w->pending[i] && spuWorkerWait(w, i, 0, &done) == 0)
+            total += done;
+    }
+    return ret ? ret : (s32)total;
+}
+
+s32 spuWorkerRunSoa(spuWorker *w, vecmath_soa_t *soa, u32 grain)
+{
+    u32 shared = spuWorkerSharedMask(w);
+    u32 i, n = 0, done, total = 0;
+    s32 ret = 0;
+
+    for (i = 0; i < w->count; i++)
+        n += (shared >> i) & 1;
+    if (!grain)
+        grain = (soa->count + n - 1) / (n ? n : 1);
+
+    soa->next  = 0;
+    soa->grain = (grain + 3) & ~3;
+
+    for (i = 0; i < w->count && ret == 0; i++)
+        if (shared & (1 << i))
+            ret = spuWorkerSubmit(w, i, VECMATH_KERNEL_SOA, soa, 0, 0);
+
+    for (i = 0; i < w->count; i++) {
+        if ((shared & (1 << i)) && w->pending[i] && spuWorkerWait(w, i, 0, &done) == 0)
+            total += done;
+    }
+    return ret ? ret : (s32)total;
+}
+
+s32 spuWorkerRunGather(spuWorker *w, vecmath_gather_t *gather, u32 grain)
+{
+    u32 shared = spuWorkerSharedMask(w);
+    u32 i, n = 0, done, total = 0;
+    s32 ret = 0;
+
+    for (i = 0; i < w->count; i++)
+        n += (shared >> i) & 1;
+    if (!grain)
+        grain = (gather->count + n - 1) / (n ? n : 1);
+
+    gather->next  = 0;
+    gather->grain = grain ? grain : 1;
+
+    for (i = 0; i < w->count && ret == 0; i++)
+        if (shared & (1 << i))
+            ret = spuWorkerSubmit(w, i, VECMATH_KERNEL_GATHER, gather, 0, 0);
+
+    for (i = 0; i < w->count; i++) {
+        if ((shared & (1 << i)) && w->pending[i] && spuWorkerWait(w, i, 0, &done) == 0)
+            total += done;
+    }
+    return ret ? ret : (s32)total;
+}
+
+s32 spuWorkerStop(spuWorker *w)
+{
+    u32 cause, status;
+    u32 i;
+    s32 ret = 0;
+
+    if (!w->running)
+        return 0;
+
+    /* Jobs still in flight must finish before the quit command is read */
+    for (i = 0; i < w->count; i++) {
+        if (w->pending[i])
+            spuWorkerWait(w, i, 0, NULL);
+        if (ret == 0)
+            ret = sysSpuThreadWriteMb(w->thread_id[i],
+                                      VECMATH_JOB_CMD(VECMATH_KERNEL_QUIT, 0));
+    }
+    if (ret == 0)
+        ret = sysSpuThreadGroupJoin(w->group_id, &cause, &status);
+
+    for (i = 0; i < w->count; i++)
+        sysSpuThreadDisconnectEvent(w->thread_id[i], SPU_THREAD_EVENT_USER, VECMATH_EVENT_PORT);
+    sysSpuThreadGroupDestroy(w->group_id);
+    sysEventQueueDestroy(w->queue, 0);
+    w->running = 0;
+    return ret;
+}
@@ -0,0 +1,126 @@
+#ifndef __SPU_WORKER_H__
+#define __SPU_WORKER_H__
+
+/*
+ * Persistent SPU workers: a thread group of 1..SPU_WORKER_MAX SPU threads
+ * is created once and stays resident, each thread looping on its inbound
+ * mailbox for job descriptors (see vecmath.h). Completion comes back as an
+ * SPU thread user event on a shared PPU event queue, so each job costs
+ * three mailbox writes plus the kernel's own DMA.
+ *
+ * With SPU_WORKER_NOTIFY_STATUS the SPU instead DMAs a 16-byte status
+ * quadword (vecmath_status_t) into the worker struct, and the PPU spins on
+ * it: no lv2 round trip, at the price of a busy PPU thread while waiting.
+ */
+#include <ppu-types.h>
+#include <sys/spu.h>
+#include <sys/event_queue.h>
+
+#include "vecmath.h"
+
+#define SPU_WORKER_MAX  6   /* SPEs available to a game process */
+
+/* How workers report completion (spuWorkerSetNotify) */
+#define SPU_WORKER_NOTIFY_EVENT     0   /* throw_event to the event queue */
+#define SPU_WORKER_NOTIFY_STATUS    1   /* fenced status quadword, polled */
+
+#define SPU_WORKER_BUSY 1   /* poll: job still running; wait: timed out */
+
+typedef struct {
+    /* One status quadword per thread, all in one line for spuWorkerWaitAny */
+    vecmath_status_t status[SPU_WORKER_MAX] __attribute__((aligned(128)));
+    u32 group_id;
+    u32 count;                          /* threads in the group */
+    u32 thread_id[SPU_WORKER_MAX];
+    u32 pending[SPU_WORKER_MAX];        /* job submitted, not yet waited for */
+    u32 completed[SPU_WORKER_MAX];      /* completion event already received */
+    u32 result[SPU_WORKER_MAX];
+    u32 seq[SPU_WORKER_MAX];            /* jobs submitted, see vecmath_status_t */
+    u32 notify;                         /* SPU_WORKER_NOTIFY_* */
+    u32 reserved;                       /* bit n: worker n kept out of the shared helpers */
+    sys_event_queue_t queue;
+    u32 running;
+} spuWorker;
+
+/*
+ * Create a group of 'nthreads' workers (clamped to 1..SPU_WORKER_MAX),
+ * connect their completion events and start them.
+ */
+s32 spuWorkerStart(spuWorker *w, sysSpuImage *image, u32 nthreads);
+
+/*
+ * Queue a job on worker 'index'. 'chunk' is only used by
+ * VECMATH_KERNEL_BATCH (0 = default). Only one job may be in flight per
+ * worker; returns -1 if the previous one is still pending.
+ */
+s32 spuWorkerSubmit(spuWorker *w, u32 index, u32 kernel, void *ea, u32 size, u32 chunk);
+
+/*
+ * Choose how jobs submitted from now on report completion
+ * (SPU_WORKER_NOTIFY_*). Returns -1 while any job is pending.
+ */
+s32 spuWorkerSetNotify(spuWorker *w, u32 notify);
+
+/*
+ * Check worker 'index' without blocking: 0 once its job has completed
+ * (the processed size goes to 'result'), SPU_WORKER_BUSY while it runs,
+ * -1 if nothing is pending. In event mode this costs a receive syscall
+ * with a 1 us timeout; in status mode, one cached load.
+ */
+s32 spuWorkerPoll(spuWorker *w, u32 index, u32 *result);
+
+/*
+ * Block until worker 'index' completes its job or 'timeout_usec' elapses
+ * (0 = wait forever). On success stores the processed size in 'result'.
+ * A timeout returns the event queue's error in event mode and
+ * SPU_WORKER_BUSY in status mode.
+ */
+s32 spuWorkerWait(spuWorker *w, u32 index, u64 timeout_usec, u32 *result);
+
+/*
+ * Wait until any pending job among the workers in 'mask' (bit n = worker
+ * n; 0 = all) completes, and retire it: its index goes to 'index' and its
+ * processed size to 'result'. Timeouts as in spuWorkerWait; -1 if none of
+ * them has a job pending.
+ */
+s32 spuWorkerWaitAny(spuWorker *w, u32 mask, u64 timeout_usec, u32 *index, u32 *result);
+
+/*
+ * Take worker 'index' out of (reserve = 1) or back into (0) the set the
+ * all-worker helpers below and the SPU tile back end submit to, so one
+ * client can keep a job in flight on it across frames. Returns -1 for a
+ * bad index or if taking it would leave no shared worker.
+ */
+s32 spuWorkerReserve(spuWorker *w, u32 index, u32 reserve);
+
+/* Bit n set if worker n is not reserved */
+u32 spuWorkerSharedMask(const spuWorker *w);
+
+/*
+ * Split 'count' vectors across every worker through a shared work queue
+ * (VECMATH_KERNEL_QUEUE). Workers claim 'grain' vectors at a time with
+ * atomic reservations, so load balances without PPU-side locking.
+ * Returns the number of vectors processed, or a negative error.
+ */
+s32 spuWorkerRunQueue(spuWorker *w, vecmath_queue_t *queue, vecmath_vec_t *vecs,
+                      u32 count, u32 grain, u32 chunk);
+
+/*
+ * Process a SoA batch (VECMATH_KERNEL_SOA) on every worker, which claim
+ * 'grain' vectors at a time from the batch header (rounded up to a
+ * multiple of 4; 0 = split evenly). Returns the number of vectors
+ * processed, or a negative error.
+ */
+s32 spuWorkerRunSoa(spuWorker *w, vecmath_soa_t *soa, u32 grain);
+
+/*
+ * Run a DMA-list gather (VECMATH_KERNEL_GATHER, see vecmath_gather.h) on
+ * every worker, which claim 'grain' elements at a time (0 = split
+ * evenly). Returns the number of vectors processed, or a negative error.
+ */
+s32 spuWorkerRunGather(spuWorker *w, vecmath_gather_t *gather, u32 grain);
+
+/* Send the quit command to every worker, join the group and clean up */
+s32 spuWorkerStop(spuWorker *w);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * Frame-pipelined SPU compute (see spupipe.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "spupipe.h"
+#include "timer.h"
+
+typedef struct {
+    vecmath_vec_t vecs[SPUPIPE_VECTORS] __attribute__((aligned(128)));
+    u32 frame;              /* frame that submitted it */
+} pipeSlot;
+
+static spuWorker   *pool;
+static u32          worker;
+static pipeSlot    *slots;
+static s32          inflight = -1;
+static s32          ready    = -1;
+static u64          batch_ticks;
+static u64          stall_ticks;
+static u64          latency_sum;
+static spuPipeStats stats;
+
+/* Per-frame inputs: a slow sweep so the displayed results move */
+static void fill(pipeSlot *s, u32 frame)
+{
+    float t = (float)(frame % 600) / 600.0f;
+    u32 i;
+
+    for (i = 0; i < SPUPIPE_VECTORS; i++) {
+        s->vecs[i].input[0] = t + 0.001f * (float)i;
+        s->vecs[i].input[1] = 1.0f - t;
+        s->vecs[i].input[2] = 0.5f * t;
+        s->vecs[i].input[3] = (float)(i & 15);
+    }
+    s->frame = frame;
+}
+
+static s32 submit(s32 slot, u32 frame)
+{
+    s32 ret;
+
+    fill(&slots[slot], frame);
+
+    /* The inputs must reach memory before the SPU's get of them can start */
+    __sync();
+    ret = spuWorkerSubmit(pool, worker, VECMATH_KERNEL_BATCH, slots[slot].vecs,
+                          SPUPIPE_VECTORS, 0);
+    if (ret == 0) {
+        inflight = slot;
+        stats.submitted++;
+    }
+    return ret;
+}
+
+static void updateHidden(void)
+{
+    double work = (double)batch_ticks * stats.completed;
+
+    stats.stall_us   = timerToUsec(stall_ticks);
+    stats.hidden_pct = work > 0.0 && stall_ticks < work
+                     ? 100.0 * (work - stall_ticks) / work : 0.0;
+}
+
+s32 spuPipeStart(spuWorker *w, u32 index)
+{
+    u64 t0;
+    s32 ret;
+
+    if (pool || spuWorkerReserve(w, index, 1) != 0)
+        return -1;
+    slots = (pipeSlot *)memalign(128, SPUPIPE_SLOTS * sizeof(pipeSlot));
+    if (!slots) {
+        spuWorkerReserve(w, index, 0);
+        return -1;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    pool     = w;
+    worker   = index;
+    inflight = -1;
+    ready    = -1;
+    stall_ticks = 0;
+    latency_sum = 0;
+
+    /* One synchronous batch: the SPU cost the pipeline tries to hide */
+    t0  = timerNow();
+    ret = submit(0, 0);
+    if (ret == 0)
+        ret = spuWorkerWait(pool, worker, 0, NULL);
+    batch_ticks    = timerNow() - t0;
+    stats.batch_us = timerToUsec(batch_ticks);
+    inflight = -1;
+    stats.submitted = 0;
+
+    if (ret) {
+        spuPipeStop();
+        return ret;
+    }
+    return 0;
+}
+
+void spuPipeFrame(u32 frame)
+{
+    u32 age;
+    s32 ret, s;
+
+    if (!pool)
+        return;
+
+    if (inflight >= 0) {
+        age = frame - slots[inflight].frame;
+        ret = spuWorkerPoll(pool, worker, NULL);
+        if (ret == SPU_WORKER_BUSY && age >= SPUPIPE_MAX_LATENCY) {
+            u64 t0 = timerNow();
+
+            ret = spuWorkerWait(pool, worker, 0, NULL);
+            stall_ticks += timerNow() - t0;
+            stats.stalls++;
+        }
+
+        if (ret == SPU_WORKER_BUSY) {
+            /* One job per worker: this frame's batch waits for the next */
+            stats.skipped++;
+            return;
+        }
+        if (ret == 0) {
+            ready = inflight;
+            stats.completed++;
+            stats.latency = age;
+            if (age > stats.latency_max)
+                stats.latency_max = age;
+            latency_sum += age;
+            stats.latency_avg = (double)latency_sum / stats.completed;
+            updateHidden();
+        }
+        inflight = -1;
+    }
+
+    /* Nothing is in flight now; fill the slot that is not on display */
+    s = ready < 0 ? 0 : (ready + 1) % SPUPIPE_SLOTS;
+    submit(s, frame);
+}
+
+const vecmath_vec_t *spuPipeResults(u32 *frame)
+{
+    if (ready < 0)
+        return NULL;
+    if (frame)
+        *frame = slots[ready].frame;
+    return slots[ready].vecs;
+}
+
+const spuPipeStats *spuPipeGetStats(void)
+{
+    return &stats;
+}
+
+void spuPipeStop(void)
+{
+    if (!pool)
+        return;
+    if (inflight >= 0)
+        spuWorkerWait(pool, worker, 0, NULL);
+    spuWorkerReserve(pool, worker, 0);
+    free(slots);
+    slots    = NULL;
+    pool     = NULL;
+    inflight = -1;
+    ready    = -1;
+}
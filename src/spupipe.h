@@ -0,0 +1,65 @@
+#ifndef __SPUPIPE_H__
+#define __SPUPIPE_H__
+
+/*
+ * Frame-pipelined SPU compute. Every frame the PPU fills a batch of input
+ * vectors in a ring of slots in main memory and submits it to a worker it
+ * has reserved (spuWorkerReserve), then goes on rendering and waiting for
+ * the flip while the SPU runs. The batch is picked up at the start of a
+ * later frame, normally the next one; only if it is SPUPIPE_MAX_LATENCY
+ * frames old does the PPU block for it.
+ *
+ * Two slots: while one is in flight the other holds the results on
+ * display. A slot is only read after its completion has been seen (status
+ * load or event, both ordered before the result loads) and only refilled
+ * once the other slot has replaced it on display, so results are never
+ * read mid-DMA and inputs never change under the SPU's get.
+ */
+#include <ppu-types.h>
+
+#include "vecmath.h"
+#include "spu_worker.h"
+
+#define SPUPIPE_SLOTS       2
+#define SPUPIPE_VECTORS     1024    /* per batch */
+#define SPUPIPE_MAX_LATENCY 2       /* frames before the PPU waits for a batch */
+
+typedef struct {
+    u32    submitted;
+    u32    completed;
+    u32    skipped;         /* frames without a submit: previous batch still running */
+    u32    stalls;          /* pickups that had to block */
+    u32    latency;         /* frames from submit to pickup, last batch */
+    u32    latency_max;
+    double latency_avg;
+    double batch_us;        /* one batch run synchronously by spuPipeStart() */
+    double stall_us;        /* PPU time spent blocked on batches */
+    double hidden_pct;      /* share of the SPU work the PPU did not wait for */
+} spuPipeStats;
+
+/*
+ * Reserve worker 'index' of 'w', allocate the slots and time one batch.
+ * Returns 0, -1 if the worker can't be reserved or memory runs out, or
+ * the batch's error.
+ */
+s32 spuPipeStart(spuWorker *w, u32 index);
+
+/*
+ * Once per frame, before waiting for the flip: pick up the batch in
+ * flight if it is done (or SPUPIPE_MAX_LATENCY frames old), then submit
+ * the batch for 'frame'. No-op until spuPipeStart() succeeds.
+ */
+void spuPipeFrame(u32 frame);
+
+/*
+ * Latest completed batch, or NULL. 'frame' gets the frame that submitted
+ * it. Valid until the next spuPipeFrame().
+ */
+const vecmath_vec_t *spuPipeResults(u32 *frame);
+
+const spuPipeStats *spuPipeGetStats(void);
+
+/* Wait for the batch in flight and release the worker */
+void spuPipeStop(void);
+
+#endif
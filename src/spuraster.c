@@ -0,0 +1,155 @@
+/*
+ * SPU tile rasteriser back end: display list recording + SPU dispatch.
+ */
+
+#include <string.h>
+#include <malloc.h>
+
+#include "spuraster.h"
+
+static spuWorker       *pool;
+static spudraw_cmd_t   *cmds;
+static u32             *ticks;
+static u32              ncmds;
+static u32              dropped;
+static spudraw_frame_t  frame __attribute__((aligned(128)));
+static spuDrawStats     stats;
+
+s32 spuDrawInit(spuWorker *workers)
+{
+    pool = workers;
+    if (!cmds)
+        cmds = (spudraw_cmd_t *)memalign(128, SPUDRAW_MAX_CMDS * sizeof(spudraw_cmd_t));
+    if (!ticks)
+        ticks = (u32 *)memalign(128, SPUDRAW_MAX_TILES * sizeof(u32));
+    return cmds && ticks ? 0 : -1;
+}
+
+const spuDrawStats *spuDrawGetStats(void)
+{
+    return &stats;
+}
+
+static spudraw_cmd_t *append(void)
+{
+    if (ncmds >= SPUDRAW_MAX_CMDS) {
+        dropped++;
+        return NULL;
+    }
+    return &cmds[ncmds++];
+}
+
+static void spuFill(const glyphTarget *t, const textRect *r, u32 color)
+{
+    spudraw_cmd_t *c;
+
+    (void)t;
+    if (!r->w || !r->h || !(c = append()))
+        return;
+
+    c->kind  = SPUDRAW_CMD_FILL;
+    c->x     = (u16)r->x;
+    c->y     = (u16)r->y;
+    c->w     = (u16)r->w;
+    c->h     = (u16)r->h;
+    c->color = color;
+}
+
+/* Lay the string out on the PPU: one command per visible glyph */
+static void spuDraw(const glyphTarget *t, const char *str, u32 x, u32 y,
+                    u32 color, u32 scale, u32 bg)
+{
+    u32 cx = x;
+
+    (void)bg;
+    if (scale < 1 || scale > 255)
+        return;
+
+    for (; *str; str++) {
+        spudraw_cmd_t *c;
+        char ch = *str;
+
+        if (ch == '\n') {
+            cx = x;
+            y += FONT_H * scale + 2;
+            continue;
+        }
+        if (ch != ' ' && cx < t->width && y < t->height && (c = append())) {
+            if (ch < FONT_FIRST || ch > FONT_LAST)
+                ch = '?';
+            c->kind  = SPUDRAW_CMD_GLYPH;
+            c->x     = (u16)cx;
+            c->y     = (u16)y;
+            c->ch    = (u8)ch;
+            c->scale = (u8)scale;
+            c->color = color;
+        }
+        cx += FONT_W * scale;
+    }
+}
+
+static void updateStats(u32 drawn)
+{
+    u64 sum = 0;
+    u32 i, n = 0;
+
+    stats.tiles       = frame.tile_count;
+    stats.tiles_drawn = drawn;
+    stats.cmds        = ncmds;
+    stats.dropped     = dropped;
+    stats.ticks_min   = ~0U;
+    stats.ticks_max   = 0;
+
+    for (i = 0; i < frame.tile_count; i++) {
+        if (!ticks[i])
+            continue;
+        sum += ticks[i];
+        n++;
+        if (ticks[i] < stats.ticks_min) stats.ticks_min = ticks[i];
+        if (ticks[i] > stats.ticks_max) stats.ticks_max = ticks[i];
+    }
+    stats.ticks_avg = n ? (u32)(sum / n) : 0;
+    if (!n)
+        stats.ticks_min = 0;
+}
+
+static void spuFlush(const glyphTarget *t)
+{
+    u32 tiles_y, i, shared, done, drawn = 0;
+
+    /* Tile rows are DMA'd as whole quadwords */
+    if (!ncmds || !pool || !pool->running || (t->width & 3))
+        goto reset;
+
+    frame.tiles_x    = (t->width  + SPUDRAW_TILE_W - 1) / SPUDRAW_TILE_W;
+    tiles_y          = (t->height + SPUDRAW_TILE_H - 1) / SPUDRAW_TILE_H;
+    frame.next_tile  = 0;
+    frame.tile_count = frame.tiles_x * tiles_y;
+    frame.grain      = 1;
+    frame.fb_ea      = (u32)(uintptr_t)t->ptr;
+    frame.pitch      = t->pitch;
+    frame.width      = t->width;
+    frame.height     = t->height;
+    frame.cmds_ea    = (u32)(uintptr_t)cmds;
+    frame.cmd_count  = ncmds;
+    frame.ticks_ea   = frame.tile_count <= SPUDRAW_MAX_TILES ? (u32)(uintptr_t)ticks : 0;
+    if (frame.ticks_ea)
+        memset(ticks, 0, frame.tile_count * sizeof(u32));
+
+    /* Reserved workers (see spupipe.c) keep their own jobs in flight */
+    shared = spuWorkerSharedMask(pool);
+    for (i = 0; i < pool->count; i++)
+        if (shared & (1 << i))
+            spuWorkerSubmit(pool, i, VECMATH_KERNEL_TILES, &frame, 0, 0);
+    for (i = 0; i < pool->count; i++) {
+        if ((shared & (1 << i)) && pool->pending[i] && spuWorkerWait(pool, i, 0, &done) == 0)
+            drawn += done;
+    }
+    updateStats(drawn);
+
+reset:
+    ncmds   = 0;
+    dropped = 0;
+}
+
+const textBackend textBackendSpu = { "spu", spuFill, spuDraw, spuFlush };
@@ -0,0 +1,38 @@
+#ifndef __SPURASTER_H__
+#define __SPURASTER_H__
+
+/*
+ * SPU tile rasteriser back end for the text layer.
+ *
+ * fill/draw only append to a per-frame display list (include/spudraw.h);
+ * flush hands the list to every resident SPU worker, which split the
+ * framebuffer's tiles between them and DMA finished tiles straight into
+ * RSX memory. The PPU only lays out text.
+ */
+#include <ppu-types.h>
+
+#include "spu_worker.h"
+#include "textlayer.h"
+#include "spudraw.h"
+
+/* Per-frame tile timings, in time-base ticks (SPU decrementer) */
+typedef struct {
+    u32 tiles;          /* tiles in the frame */
+    u32 tiles_drawn;    /* tiles touched by at least one command */
+    u32 cmds;
+    u32 dropped;        /* commands past SPUDRAW_MAX_CMDS */
+    u32 ticks_min;
+    u32 ticks_avg;
+    u32 ticks_max;
+} spuDrawStats;
+
+/* Allocate the display list (once) and bind the back end to 'workers' */
+s32 spuDrawInit(spuWorker *workers);
+
+/* Timings of the last flushed frame */
+const spuDrawStats *spuDrawGetStats(void);
+
+/* Back end to hand to textLayerSetBackend() once spuDrawInit() succeeded */
+extern const textBackend textBackendSpu;
+
+#endif
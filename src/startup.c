@@ -0,0 +1,87 @@
+/*
+ * Startup trace (see startup.h).
+ */
+
+#include <stdio.h>
+
+#include "startup.h"
+#include "timer.h"
+
+typedef struct {
+    const char *name;
+    s32 ret;
+    u64 time;       /* time base at the mark */
+} startupStep;
+
+static const char *lane_names[STARTUP_LANES] = { "main", "spe" };
+
+static u64            start;
+static startupStep    steps[STARTUP_LANES][STARTUP_MAX_STEPS];
+static u64            last[STARTUP_LANES];
+static startupSummary summary;
+
+static double sinceStart(u64 t)
+{
+    return timerToUsec(t - start) / 1000.0;
+}
+
+void startupBegin(void)
+{
+    u32 l;
+
+    start = timerNow();
+    for (l = 0; l < STARTUP_LANES; l++)
+        last[l] = start;
+}
+
+s32 startupMark(u32 lane, const char *name, s32 ret)
+{
+    u64 now = timerNow();
+    u32 n = summary.steps[lane];
+
+    if (n < STARTUP_MAX_STEPS) {
+        steps[lane][n].name = name;
+        steps[lane][n].ret  = ret;
+        steps[lane][n].time = now;
+        /* The step before the count that exposes it to other lanes */
+        __lwsync();
+        summary.steps[lane] = n + 1;
+    }
+
+    /* Calls on a lane run back to back, so the gap is the call's own time */
+    printf("startup: %8.3f ms  %-4s %-24s ret=%d  (+%.3f ms)\n",
+           sinceStart(now), lane_names[lane], name, ret,
+           timerToUsec(now - last[lane]) / 1000.0);
+    last[lane] = now;
+    summary.lane_ms[lane] = sinceStart(now);
+    return ret;
+}
+
+void startupFirstFrame(void)
+{
+    u32 count[STARTUP_LANES];
+    u32 l, i, failed = 0;
+
+    summary.first_frame_ms = sinceStart(timerNow());
+
+    /* The SPE lane may still be marking: take each count once... */
+    for (l = 0; l < STARTUP_LANES; l++)
+        count[l] = ((volatile u32 *)summary.steps)[l];
+
+    /* ...and read the steps only after the counts that published them */
+    __lwsync();
+    for (l = 0; l < STARTUP_LANES; l++)
+        for (i = 0; i < count[l]; i++)
+            if (steps[l][i].ret)
+                failed++;
+
+    printf("startup: first frame at %.3f ms (main %u steps %.3f ms, spe %u steps %.3f ms, %u failed)\n",
+           summary.first_frame_ms,
+           count[STARTUP_MAIN], summary.lane_ms[STARTUP_MAIN],
+           count[STARTUP_SPE], summary.lane_ms[STARTUP_SPE], failed);
+}
+
+const startupSummary *startupGetSummary(void)
+{
+    return &summary;
+}
@@ -0,0 +1,38 @@
+#ifndef __STARTUP_H__
+#define __STARTUP_H__
+
+/*
+ * Startup trace. Each init call is recorded with its time base stamp and
+ * return code on a lane (one per thread taking part in startup), printed
+ * as it happens, and summarised when the first frame is queued for flip.
+ * A lane is only ever written by its own thread, so marking takes no lock.
+ */
+#include <ppu-types.h>
+
+#define STARTUP_MAX_STEPS   24      /* per lane; later marks are printed only */
+
+/* Lanes: the main thread and the SPU bring-up thread */
+enum {
+    STARTUP_MAIN,
+    STARTUP_SPE,
+    STARTUP_LANES
+};
+
+typedef struct {
+    u32    steps[STARTUP_LANES];
+    double lane_ms[STARTUP_LANES];  /* last mark of each lane, from startupBegin() */
+    double first_frame_ms;          /* 0 until startupFirstFrame() */
+} startupSummary;
+
+/* Take the reference time; call first thing in main() */
+void startupBegin(void);
+
+/* Record a finished init call on 'lane'. Returns 'ret' so it can wrap the call. */
+s32 startupMark(u32 lane, const char *name, s32 ret);
+
+/* The first frame has been queued for flip: record it and print the summary */
+void startupFirstFrame(void);
+
+const startupSummary *startupGetSummary(void);
+
+#endif
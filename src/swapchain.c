@@ -0,0 +1,230 @@
+/*
+ * Display swapchain with flip-handler driven waits (see swapchain.h).
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/event_queue.h>
+
+#include "swapchain.h"
+#include "timer.h"
+
+static gcmContextData *ctx;
+static swapBuffer      buffers[SWAP_MAX_BUFFERS];
+static u32             count;
+static u32             current;
+static u32             presented;
+
+/* Buffer for present number s is (base_buf + s - base) % count */
+static u32             base;
+static u32             base_buf;
+
+/* Written by the GCM handlers, read by the PPU main thread */
+static volatile u32    flips_done;
+static volatile u32    vblanks;
+static volatile u32    missed;
+static u32             last_flip_vblank;
+
+static sys_event_queue_t queue;
+static sys_event_port_t  port;
+static int               use_events;
+
+static swapStats stats;
+static u64       window_t0;
+static u64       window_idle;
+static u32       window_missed;
+
+static void onVBlank(const u32 head)
+{
+    (void)head;
+    vblanks++;
+}
+
+/*
+ * A flip normally lands one vblank after the previous one; every extra
+ * vblank in between showed the old frame again.
+ */
+static void onFlip(const u32 head)
+{
+    u32 v = vblanks;
+
+    (void)head;
+    if (flips_done && v - last_flip_vblank > 1)
+        missed += v - last_flip_vblank - 1;
+    last_flip_vblank = v;
+    flips_done++;
+
+    if (use_events)
+        sysEventPortSend(port, flips_done, 0, 0);
+}
+
+static void makeBuffer(u32 id, u32 width, u32 height)
+{
+    u32 pitch = width * sizeof(u32);        /* 4 bytes per pixel, XRGB */
+    u32 size  = pitch * height;
+
+    buffers[id].ptr    = (u32 *)rsxMemalign(64, size);
+    buffers[id].width  = width;
+    buffers[id].height = height;
+    buffers[id].pitch  = pitch;
+
+    rsxAddressToOffset(buffers[id].ptr, &buffers[id].offset);
+    gcmSetDisplayBuffer(id, buffers[id].offset, pitch, width, height);
+}
+
+static s32 openEvents(void)
+{
+    sys_event_queue_attr_t qattr;
+    s32 ret;
+
+    memset(&qattr, 0, sizeof(qattr));
+    qattr.attr_protocol = SYS_EVENT_QUEUE_PRIO;
+    qattr.type = SYS_EVENT_QUEUE_PPU;
+    strcpy(qattr.name, "swapq");
+    ret = sysEventQueueCreate(&queue, &qattr, SYS_EVENT_QUEUE_KEY_LOCAL, 8);
+    if (ret)
+        return ret;
+
+    ret = sysEventPortCreate(&port, SYS_EVENT_PORT_LOCAL, SYS_EVENT_PORT_NO_NAME);
+    if (ret)
+        goto fail_queue;
+    ret = sysEventPortConnectLocal(port, queue);
+    if (ret)
+        goto fail_port;
+    return 0;
+
+fail_port:
+    sysEventPortDestroy(port);
+fail_queue:
+    sysEventQueueDestroy(queue, 0);
+    return ret;
+}
+
+/*
+ * Sleep until the flip handler posts. Events left over from flips nobody
+ * waited for only cause an extra check of flips_done; the timeout guards
+ * against a handler that never runs.
+ */
+static void waitForFlip(void)
+{
+    sys_event_t ev;
+
+    if (use_events)
+        sysEventQueueReceive(queue, &ev, 100000);
+    else
+        usleep(200);
+}
+
+/* Wait until at most 'pending' flips are still queued */
+static void waitPending(u32 pending)
+{
+    while ((s32)(presented - flips_done) > (s32)pending)
+        waitForFlip();
+}
+
+s32 swapInit(gcmContextData *context, u32 width, u32 height, u32 n)
+{
+    u32 i;
+
+    ctx = context;
+    for (i = 0; i < SWAP_MAX_BUFFERS; i++)
+        makeBuffer(i, width, height);
+
+    use_events = openEvents() == 0;
+    gcmSetVBlankHandler(onVBlank);
+    gcmSetFlipHandler(onFlip);
+
+    count = n < 2 ? 2 : n > SWAP_MAX_BUFFERS ? SWAP_MAX_BUFFERS : n;
+
+    /* Show buffer 0; drawing starts at buffer 1 */
+    gcmResetFlipStatus();
+    current = 0;
+    swapPresent();
+    base     = presented;
+    base_buf = 1;
+
+    window_t0 = timerNow();
+    return use_events ? 0 : -1;
+}
+
+/*
+ * Present number s may be drawn once present s - count + 1 is on screen,
+ * which retires the previous use of its buffer: with two buffers every
+ * earlier flip must be done, with three one may still be queued.
+ */
+swapBuffer *swapAcquire(void)
+{
+    u64 t0 = timerNow();
+
+    waitPending(count - 2);
+    stats.idle_ticks += timerNow() - t0;
+
+    current = (base_buf + presented - base) % count;
+    return &buffers[current];
+}
+
+u32 swapCurrent(void)
+{
+    return current;
+}
+
+void swapPresent(void)
+{
+    gcmSetFlip(ctx, (u8)current);
+    rsxFlushBuffer(ctx);
+    gcmSetWaitFlip(ctx);
+    presented++;
+
+    stats.presented = presented;
+    stats.flipped   = flips_done;
+    stats.missed    = missed;
+
+    if (presented % SWAP_STATS_FRAMES == 0) {
+        u64 now = timerNow();
+
+        stats.idle_pct      = now > window_t0 ?
+            100.0 * (double)(stats.idle_ticks - window_idle) / (double)(now - window_t0) : 0.0;
+        stats.missed_window = missed - window_missed;
+        window_t0     = now;
+        window_idle   = stats.idle_ticks;
+        window_missed = missed;
+    }
+}
+
+void swapSetCount(u32 n)
+{
+    n = n < 2 ? 2 : n > SWAP_MAX_BUFFERS ? SWAP_MAX_BUFFERS : n;
+    if (n == count)
+        return;
+
+    /* With nothing queued only 'current' is on screen; rotate from the next one */
+    waitPending(0);
+    count    = n;
+    base     = presented;
+    base_buf = (current + 1) % n;
+}
+
+u32 swapGetCount(void)
+{
+    return count;
+}
+
+const swapStats *swapGetStats(void)
+{
+    return &stats;
+}
+
+void swapShutdown(void)
+{
+    waitPending(0);
+    gcmSetFlipHandler(NULL);
+    gcmSetVBlankHandler(NULL);
+
+    if (use_events) {
+        use_events = 0;
+        sysEventPortDisconnect(port);
+        sysEventPortDestroy(port);
+        sysEventQueueDestroy(queue, 0);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef __SWAPCHAIN_H__
+#define __SWAPCHAIN_H__
+
+/*
+ * Display swapchain: 2 or 3 framebuffers in rotation.
+ *
+ * swapPresent() queues a flip and returns at once; swapAcquire() blocks
+ * only until the next buffer in rotation is neither on screen nor waiting
+ * to be, sleeping on an event queue the GCM flip handler posts to. With
+ * three buffers the PPU can draw frame N+1 while N is still queued.
+ */
+#include <ppu-types.h>
+#include <rsx/rsx.h>
+#include <rsx/gcm_sys.h>
+
+#define SWAP_MAX_BUFFERS    3
+#define SWAP_STATS_FRAMES   60      /* frames per pacing window */
+
+typedef struct {
+    u32  width;
+    u32  height;
+    u32  pitch;
+    u32 *ptr;
+    u32  offset;
+} swapBuffer;
+
+/* Frame pacing, refreshed every SWAP_STATS_FRAMES presents */
+typedef struct {
+    u32    presented;       /* flips queued since start */
+    u32    flipped;         /* flips completed (flip handler) */
+    u32    missed;          /* vblanks that repeated a frame, since start */
+    u32    missed_window;   /* ... in the last window */
+    u64    idle_ticks;      /* time blocked in swapAcquire(), since start */
+    double idle_pct;        /* share of the last window spent blocked */
+} swapStats;
+
+/*
+ * Allocate SWAP_MAX_BUFFERS framebuffers, register them with GCM, install
+ * the flip/vblank handlers and show buffer 0. 'count' (2 or 3) buffers
+ * are used in rotation. Falls back to polling if no event queue.
+ */
+s32 swapInit(gcmContextData *context, u32 width, u32 height, u32 count);
+
+/* Wait until the next buffer may be drawn; returns it */
+swapBuffer *swapAcquire(void);
+
+/* Index (0..SWAP_MAX_BUFFERS-1) of the buffer returned by swapAcquire() */
+u32 swapCurrent(void);
+
+/* Queue a flip to the acquired buffer (does not wait for it) */
+void swapPresent(void);
+
+/* Change the rotation to 2 or 3 buffers; drains pending flips first */
+void swapSetCount(u32 count);
+u32  swapGetCount(void);
+
+const swapStats *swapGetStats(void);
+
+/* Wait for pending flips and remove the handlers */
+void swapShutdown(void);
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ * Retained-mode text layer (dirty-rectangle redraw).
+ */
+
+#include <string.h>
+
+#include "fill.h"
+#include "textlayer.h"
+#include "timer.h"
+
+#define TEXT_LINE_GAP   2   /* extra pixels between lines, as glyphDrawString */
+
+/* Lit pixels per glyph, for the bytes-written counter */
+static u8 glyph_lit[FONT_LAST - FONT_FIRST + 1];
+static u8 glyph_lit_ready;
+
+static void countLitPixels(void)
+{
+    u32 g, r;
+
+    for (g = 0; g < sizeof(glyph_lit); g++) {
+        u32 n = 0;
+        for (r = 0; r < FONT_H; r++) {
+            u8 bits = font8x8[g][r];
+            while (bits) {
+                n += bits & 1;
+                bits >>= 1;
+            }
+        }
+        glyph_lit[g] = (u8)n;
+    }
+    glyph_lit_ready = 1;
+}
+
+static u32 textBytes(const char *str, u32 scale)
+{
+    u32 n = 0;
+
+    for (; *str; str++) {
+        char c = *str;
+        if (c == '\n')
+            continue;
+        if (c < FONT_FIRST || c > FONT_LAST)
+            c = '?';
+        n += glyph_lit[c - FONT_FIRST];
+    }
+    return n * scale * scale * sizeof(u32);
+}
+
+/* Bounding box of a (possibly multi-line) string, clipped to the target */
+static textRect measure(const char *str, u32 x, u32 y, u32 scale,
+                        u32 width, u32 height)
+{
+    textRect r;
+    u32 cols = 0, maxcols = 0, lines = 1;
+
+    for (; *str; str++) {
+        if (*str == '\n') {
+            lines++;
+            cols = 0;
+        } else if (++cols > maxcols) {
+            maxcols = cols;
+        }
+    }
+
+    r.x = x;
+    r.y = y;
+    r.w = maxcols * FONT_W * scale;
+    r.h = lines * (FONT_H * scale + TEXT_LINE_GAP) - TEXT_LINE_GAP;
+
+    if (r.x >= width || r.y >= height || r.w == 0) {
+        r.w = r.h = 0;
+        return r;
+    }
+    if (r.w > width - r.x)
+        r.w = width - r.x;
+    if (r.h > height - r.y)
+        r.h = height - r.y;
+    return r;
+}
+
+static int overlaps(const textRect *a, const textRect *b)
+{
+    return a->w && b->w &&
+           a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static int sameItem(const textItem *a, const textItem *b)
+{
+    return a->x == b->x && a->y == b->y && a->color == b->color &&
+           a->scale == b->scale && strcmp(a->str, b->str) == 0;
+}
+
+/* Framebuffers are RSX-mapped (cache-inhibited), so no FILL_CACHED */
+static void fillRect(const glyphTarget *t, const textRect *r, u32 color)
+{
+    fillRows(t->ptr + r->y * (t->pitch / 4) + r->x, t->pitch, r->w, r->h, color, 0);
+}
+
+static void drawSoftware(const glyphTarget *t, const char *str, u32 x, u32 y,
+                         u32 color, u32 scale, u32 bg)
+{
+    (void)bg;
+    glyphDrawString(t, str, x, y, color, scale);
+}
+
+const textBackend textBackendSoftware = { "ppu", fillRect, drawSoftware, NULL };
+
+static void drawItem(textLayer *l, const glyphTarget *t, const textItem *it)
+{
+    l->backend->draw(t, it->str, it->x, it->y, it->color, it->scale, l->bg);
+    l->stats.bytes_text += textBytes(it->str, it->scale);
+    l->stats.items_drawn++;
+}
+
+void textLayerInit(textLayer *l, textRedrawMode mode)
+{
+    memset(l, 0, sizeof(*l));
+    l->mode    = mode;
+    l->backend = &textBackendSoftware;
+    if (!glyph_lit_ready)
+        countLitPixels();
+}
+
+void textLayerSetBackend(textLayer *l, const textBackend *backend)
+{
+    l->backend = backend;
+    textLayerInvalidate(l);
+}
+
+void textLayerInvalidate(textLayer *l)
+{
+    u32 i;
+
+    for (i = 0; i < TEXT_MAX_BUFFERS; i++)
+        l->buffers[i].valid = 0;
+}
+
+void textLayerBegin(textLayer *l, u32 bg)
+{
+    l->bg    = bg;
+    l->count = 0;
+    memset(&l->stats, 0, sizeof(l->stats));
+}
+
+void textLayerAdd(textLayer *l, const char *str, u32 x, u32 y, u32 color, u32 scale)
+{
+    textItem *it;
+
+    if (l->count >= TEXT_MAX_ITEMS)
+        return;
+
+    it = &l->frame[l->count++];
+    strncpy(it->str, str, TEXT_MAX_LEN - 1);
+    it->str[TEXT_MAX_LEN - 1] = '\0';
+    it->x     = x;
+    it->y     = y;
+    it->color = color;
+    it->scale = scale;
+    /* rect is filled in textLayerEnd, once the target size is known */
+}
+
+void textLayerEnd(textLayer *l, const glyphTarget *t, u32 buffer)
+{
+    textBufferState *st = &l->buffers[buffer % TEXT_MAX_BUFFERS];
+    textRect dirty[2 * TEXT_MAX_ITEMS];
+    u32 ndirty = 0;
+    u32 i, j, n;
+    u64 t0;
+
+    for (i = 0; i < l->count; i++)
+        l->frame[i].rect = measure(l->frame[i].str, l->frame[i].x, l->frame[i].y,
+                                   l->frame[i].scale, t->width, t->height);
+
+    if (l->mode == TEXT_REDRAW_FULL || !st->valid || st->bg != l->bg) {
+        textRect all = { 0, 0, t->width, t->height };
+
+        t0 = timerNow();
+        l->backend->fill(t, &all, l->bg);
+        l->stats.clear_ticks += timerNow() - t0;
+        l->stats.bytes_cleared += t->width * t->height * sizeof(u32);
+        l->stats.rects++;
+        for (i = 0; i < l->count; i++)
+            drawItem(l, t, &l->frame[i]);
+        goto done;
+    }
+
+    /* An item that changed dirties both where it was and where it is now */
+    n = l->count > st->count ? l->count : st->count;
+    for (i = 0; i < n; i++) {
+        const textItem *old = i < st->count ? &st->items[i] : NULL;
+        const textItem *cur = i < l->count  ? &l->frame[i]  : NULL;
+
+        if (old && cur && sameItem(old, cur))
+            continue;
+        if (old && old->rect.w)
+            dirty[ndirty++] = old->rect;
+        if (cur && cur->rect.w)
+            dirty[ndirty++] = cur->rect;
+    }
+
+    t0 = timerNow();
+    for (i = 0; i < ndirty; i++) {
+        l->backend->fill(t, &dirty[i], l->bg);
+        l->stats.bytes_cleared += dirty[i].w * dirty[i].h * sizeof(u32);
+    }
+    l->stats.clear_ticks += timerNow() - t0;
+    l->stats.rects = ndirty;
+
+    /* Redraw everything touching a cleared area (glyph writes are idempotent) */
+    for (i = 0; i < l->count && ndirty; i++) {
+        for (j = 0; j < ndirty; j++) {
+            if (overlaps(&l->frame[i].rect, &dirty[j])) {
+                drawItem(l, t, &l->frame[i]);
+                break;
+            }
+        }
+    }
+
+done:
+    if (l->backend->flush)
+        l->backend->flush(t);
+
+    memcpy(st->items, l->frame, l->count * sizeof(textItem));
+    st->count = l->count;
+    st->bg    = l->bg;
+    st->valid = 1;
+}
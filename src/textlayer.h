@@ -0,0 +1,101 @@
+#ifndef __TEXTLAYER_H__
+#define __TEXTLAYER_H__
+
+/*
+ * Retained-mode text layer with per-buffer dirty rectangles.
+ *
+ * Each frame the caller re-declares its strings with textLayerAdd(). The
+ * layer remembers what was last drawn into every framebuffer (with double
+ * buffering a buffer is two frames stale), and on textLayerEnd() clears
+ * and redraws only the items whose content or position changed since that
+ * buffer was last drawn, plus any unchanged item overlapping a cleared
+ * area. TEXT_REDRAW_FULL keeps the original clear-everything path.
+ */
+#include <ppu-types.h>
+
+#include "glyph.h"
+
+#define TEXT_MAX_ITEMS      32
+#define TEXT_MAX_LEN        96
+#define TEXT_MAX_BUFFERS    3
+
+typedef enum {
+    TEXT_REDRAW_DIRTY = 0,
+    TEXT_REDRAW_FULL,
+} textRedrawMode;
+
+typedef struct {
+    u32 x, y, w, h;
+} textRect;
+
+typedef struct {
+    char     str[TEXT_MAX_LEN];
+    u32      x, y;
+    u32      color;
+    u32      scale;
+    textRect rect;          /* clipped bounding box */
+} textItem;
+
+/* What one framebuffer currently shows */
+typedef struct {
+    textItem items[TEXT_MAX_ITEMS];
+    u32      count;
+    u32      bg;
+    u32      valid;         /* 0 until the buffer has been fully drawn once */
+} textBufferState;
+
+/*
+ * Rendering back end used for clears and strings. 'bg' is the frame
+ * background, for back ends that blit opaque glyph cells. 'flush' (may be
+ * NULL) runs at the end of textLayerEnd(), for back ends that record the
+ * frame and render it in one go.
+ */
+typedef struct {
+    const char *name;
+    void (*fill)(const glyphTarget *t, const textRect *r, u32 color);
+    void (*draw)(const glyphTarget *t, const char *str, u32 x, u32 y,
+                 u32 color, u32 scale, u32 bg);
+    void (*flush)(const glyphTarget *t);
+} textBackend;
+
+/* PPU software rasteriser: direct stores + glyph atlas */
+extern const textBackend textBackendSoftware;
+
+/* Per-frame counters, reset by textLayerBegin() */
+typedef struct {
+    u32 bytes_cleared;      /* background fill */
+    u32 bytes_text;         /* lit glyph pixels */
+    u32 rects;              /* dirty rectangles cleared */
+    u32 items_drawn;
+    u64 clear_ticks;        /* time base spent in the back end's fills */
+} textStats;
+
+typedef struct {
+    textRedrawMode  mode;
+    const textBackend *backend;
+    u32             bg;
+    textItem        frame[TEXT_MAX_ITEMS];  /* items declared this frame */
+    u32             count;
+    textBufferState buffers[TEXT_MAX_BUFFERS];
+    textStats       stats;
+} textLayer;
+
+/* Starts on the software back end */
+void textLayerInit(textLayer *l, textRedrawMode mode);
+
+/* Switch back end; every buffer is redrawn in full on its next frame */
+void textLayerSetBackend(textLayer *l, const textBackend *backend);
+
+/* Start declaring a frame with the given background colour */
+void textLayerBegin(textLayer *l, u32 bg);
+
+/* Declare a string; items are matched to the previous frames by order */
+void textLayerAdd(textLayer *l, const char *str, u32 x, u32 y, u32 color, u32 scale);
+
+/* Bring framebuffer 'buffer' (drawn through 't') up to date */
+void textLayerEnd(textLayer *l, const glyphTarget *t, u32 buffer);
+
+/* Forget buffer contents, forcing a full redraw of every buffer */
+void textLayerInvalidate(textLayer *l);
+
+#endif
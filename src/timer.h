@@ -0,0 +1,27 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+/*
+ * Time-base register helpers used by the benchmarks.
+ * __mftb() reads the PPU time base (79.8 MHz on retail consoles).
+ */
+#include <ppu-types.h>
+#include <ppu_intrinsics.h>
+#include <sys/systime.h>
+
+static inline u64 timerNow(void)
+{
+    return __mftb();
+}
+
+static inline double timerToSec(u64 ticks)
+{
+    return (double)ticks / (double)sysGetTimebaseFrequency();
+}
+
+static inline double timerToUsec(u64 ticks)
+{
+    return timerToSec(ticks) * 1e6;
+}
+
+#endif
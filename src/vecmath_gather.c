@@ -0,0 +1,44 @@
+/*
+ * DMA-list gather descriptors and staging copies (see vecmath_gather.h).
+ */
+
+#include <string.h>
+
+#include "vecmath_gather.h"
+
+s32 vecmathGatherSetup(vecmath_gather_t *g, void *base, u32 count, u32 stride,
+                       u32 offset, const u32 *index, u32 chunk)
+{
+    if (((uintptr_t)base & 15) || (stride & 15) || (offset & 15) ||
+        ((uintptr_t)index & 15) || offset + sizeof(vecmath_vec_t) > stride ||
+        chunk > VECMATH_CHUNK_MAX)
+        return -1;
+
+    memset(g, 0, sizeof(*g));
+    g->count    = count;
+    g->grain    = count;
+    g->chunk    = chunk;
+    g->ea_base  = (u32)(uintptr_t)base;
+    g->stride   = stride;
+    g->offset   = offset;
+    g->ea_index = (u32)(uintptr_t)index;
+    return 0;
+}
+
+void vecmathGatherStage(vecmath_vec_t *staging, void *base, u32 count, u32 stride,
+                        u32 offset, const u32 *index)
+{
+    u32 i;
+
+    for (i = 0; i < count; i++)
+        staging[i] = *vecmathGatherElem(base, stride, offset, index, i);
+}
+
+void vecmathGatherUnstage(const vecmath_vec_t *staging, void *base, u32 count, u32 stride,
+                          u32 offset, const u32 *index)
+{
+    u32 i;
+
+    for (i = 0; i < count; i++)
+        *vecmathGatherElem(base, stride, offset, index, i) = staging[i];
+}
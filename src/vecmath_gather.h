@@ -0,0 +1,45 @@
+#ifndef __VECMATH_GATHER_H__
+#define __VECMATH_GATHER_H__
+
+/*
+ * PPU side of the DMA-list gather (vecmath_gather_t in vecmath.h): the
+ * job descriptor, and the staging copies it replaces, kept as the
+ * benchmark baseline and for checking results.
+ *
+ * A gather set is 'count' vecmath_vec_t embedded at 'offset' in records
+ * 'stride' bytes apart from 'base', taken in order or through 'index'
+ * (record number per element; NULL = element i is record i). The SPU
+ * reads the index array in whole quadwords, so it must be allocated for
+ * VECMATH_GATHER_INDEX_LEN(count) entries, not just 'count'.
+ */
+#include <ppu-types.h>
+
+#include "vecmath.h"
+
+/* Entries to allocate for the index of a 'count'-element set */
+#define VECMATH_GATHER_INDEX_LEN(count)     (((count) + 3) & ~3u)
+
+static inline vecmath_vec_t *vecmathGatherElem(void *base, u32 stride, u32 offset,
+                                               const u32 *index, u32 i)
+{
+    return (vecmath_vec_t *)((u8 *)base + (index ? index[i] : i) * stride + offset);
+}
+
+/*
+ * Fill 'g' for a gather set ('chunk' = elements per DMA list, 0 =
+ * default). Returns -1 if the layout breaks the DMA rules: base, stride
+ * and offset must be multiples of 16, the vector must fit in the record
+ * and the index array must be 16-byte aligned (and padded, see above).
+ */
+s32 vecmathGatherSetup(vecmath_gather_t *g, void *base, u32 count, u32 stride,
+                       u32 offset, const u32 *index, u32 chunk);
+
+/* Copy every element of the set into staging[0..count) */
+void vecmathGatherStage(vecmath_vec_t *staging, void *base, u32 count, u32 stride,
+                        u32 offset, const u32 *index);
+
+/* Copy staging[0..count) back into the records */
+void vecmathGatherUnstage(const vecmath_vec_t *staging, void *base, u32 count, u32 stride,
+                          u32 offset, const u32 *index);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * PPU reference for the SPU vecmath kernel.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "vecmath_ref.h"
+#include "vecmath_soa.h"
+
+static void refCompute(const float in[4], float out[4], float *dot, float *mag)
+{
+    u32 i;
+
+    *dot = 0.0f;
+    for (i = 0; i < 4; i++) {
+        out[i] = in[i] * in[i];
+        *dot  += out[i];
+    }
+    *mag = sqrtf(*dot);
+}
+
+static float relError(float got, float want)
+{
+    float diff = fabsf(got - want);
+    float mag  = fabsf(want);
+
+    if (isnan(got))
+        return INFINITY;
+    return mag > 1e-30f ? diff / mag : diff;
+}
+
+void vecmathRefBatch(vecmath_vec_t *v, u32 count)
+{
+    u32 i;
+
+    for (i = 0; i < count; i++)
+        refCompute(v[i].input, v[i].output, &v[i].dot_product, &v[i].magnitude);
+}
+
+float vecmathRefMaxError(const vecmath_vec_t *v, u32 count)
+{
+    float worst = 0.0f;
+    u32 i, j;
+
+    for (i = 0; i < count; i++) {
+        float out[4], dot, mag, e;
+
+        refCompute(v[i].input, out, &dot, &mag);
+        for (j = 0; j < 4; j++) {
+            e = relError(v[i].output[j], out[j]);
+            if (e > worst) worst = e;
+        }
+        e = relError(v[i].dot_product, dot);
+        if (e > worst) worst = e;
+        e = relError(v[i].magnitude, mag);
+        if (e > worst) worst = e;
+    }
+    return worst;
+}
+
+/* Gather vector i of a SoA batch */
+static void soaInput(vecmath_soa_t *soa, u32 i, float in[4])
+{
+    u32 j;
+
+    for (j = 0; j < 4; j++)
+        in[j] = vecmathSoaPlane(soa, VECMATH_SOA_X + j)[i];
+}
+
+/* Output planes (bit n = VECMATH_SOA_OUT_X + n) each op defines */
+static u32 soaOpPlanes(u32 op)
+{
+    switch (op) {
+    case VECMATH_OP_DOT:        return 0x10;
+    case VECMATH_OP_CROSS:
+    case VECMATH_OP_TRANSFORM:  return 0x0f;
+    default:                    return 0x3f;
+    }
+}
+
+/* Planes both defined by the op and requested by soa->flags */
+static u32 soaCheckedPlanes(const vecmath_soa_t *soa)
+{
+    u32 req = 0;
+
+    if (soa->flags & VECMATH_SOA_OUT_XYZW) req |= 0x0f;
+    if (soa->flags & VECMATH_SOA_OUT_DOT)  req |= 0x10;
+    if (soa->flags & VECMATH_SOA_OUT_MAG)  req |= 0x20;
+    return req & soaOpPlanes(soa->op);
+}
+
+/* Exact result of soa->op for one vector, in double: out[0..3], dot, mag */
+static void soaExpected(const vecmath_soa_t *soa, const float in[4], double out[6])
+{
+    const float *k = soa->operand;
+    double d = 0.0;
+    u32 j, c;
+
+    memset(out, 0, 6 * sizeof(double));
+    switch (soa->op) {
+    case VECMATH_OP_NORMALIZE:
+        for (j = 0; j < 4; j++)
+            d += (double)in[j] * in[j];
+        for (j = 0; j < 4; j++)
+            out[j] = d > 0.0 ? in[j] / sqrt(d) : 0.0;
+        out[4] = d;
+        out[5] = sqrt(d);
+        break;
+    case VECMATH_OP_DOT:
+        for (j = 0; j < 4; j++)
+            out[4] += (double)in[j] * k[j];
+        break;
+    case VECMATH_OP_CROSS:
+        out[0] = (double)in[1] * k[2] - (double)in[2] * k[1];
+        out[1] = (double)in[2] * k[0] - (double)in[0] * k[2];
+        out[2] = (double)in[0] * k[1] - (double)in[1] * k[0];
+        break;
+    case VECMATH_OP_TRANSFORM:
+        for (j = 0; j < 4; j++)
+            for (c = 0; c < 4; c++)
+                out[j] += (double)k[j * 4 + c] * in[c];
+        break;
+    default:
+        for (j = 0; j < 4; j++) {
+            out[j] = (double)in[j] * in[j];
+            d += out[j];
+        }
+        out[4] = d;
+        out[5] = sqrt(d);
+        break;
+    }
+}
+
+void vecmathRefSoa(vecmath_soa_t *soa)
+{
+    u32 i, j;
+
+    for (i = 0; i < soa->count; i++) {
+        float in[4];
+        double out[6];
+
+        soaInput(soa, i, in);
+        soaExpected(soa, in, out);
+        for (j = 0; j < 6; j++)
+            vecmathSoaPlane(soa, VECMATH_SOA_OUT_X + j)[i] = (float)out[j];
+    }
+}
+
+float vecmathRefSoaMaxError(vecmath_soa_t *soa)
+{
+    u32 planes = soaCheckedPlanes(soa);
+    float worst = 0.0f;
+    u32 i, j;
+
+    for (i = 0; i < soa->count; i++) {
+        float in[4], e;
+        double out[6];
+
+        soaInput(soa, i, in);
+        soaExpected(soa, in, out);
+        for (j = 0; j < 6; j++) {
+            if (!(planes & (1 << j)))
+                continue;
+            e = relError(vecmathSoaPlane(soa, VECMATH_SOA_OUT_X + j)[i], (float)out[j]);
+            if (e > worst) worst = e;
+        }
+    }
+    return worst;
+}
+
+/* Distance in representable floats; NaN is as far as it gets */
+static u32 ulpDiff(float got, float want)
+{
+    s32 a, b;
+    s64 d;
+
+    if (isnan(got) || isnan(want))
+        return 0xffffffff;
+
+    memcpy(&a, &got, sizeof(a));
+    memcpy(&b, &want, sizeof(b));
+    /* Map sign-magnitude to a monotonic integer line */
+    if (a < 0) a = (s32)0x80000000 - a;
+    if (b < 0) b = (s32)0x80000000 - b;
+    d = (s64)a - b;
+    d = d < 0 ? -d : d;
+    return d > 0xffffffffLL ? 0xffffffff : (u32)d;
+}
+
+u32 vecmathRefSoaUlp(vecmath_soa_t *soa, double *mean)
+{
+    u32 planes = soaCheckedPlanes(soa);
+    u32 worst = 0, i, j;
+    double sum = 0.0;
+    u64 n = 0;
+
+    for (i = 0; i < soa->count; i++) {
+        float in[4];
+        double out[6];
+
+        soaInput(soa, i, in);
+        soaExpected(soa, in, out);
+        for (j = 0; j < 6; j++) {
+            u32 e;
+
+            if (!(planes & (1 << j)))
+                continue;
+            e = ulpDiff(vecmathSoaPlane(soa, VECMATH_SOA_OUT_X + j)[i], (float)out[j]);
+            if (e > worst) worst = e;
+            sum += e;
+            n++;
+        }
+    }
+    if (mean)
+        *mean = n ? sum / n : 0.0;
+    return worst;
+}
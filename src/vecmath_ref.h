@@ -0,0 +1,33 @@
+#ifndef __VECMATH_REF_H__
+#define __VECMATH_REF_H__
+
+/*
+ * PPU reference implementation of the SPU vecmath kernel, used to check
+ * batch results and as the throughput baseline in the benchmarks.
+ */
+#include <ppu-types.h>
+
+#include "vecmath.h"
+
+/* Compute output/dot_product/magnitude for 'count' elements in place */
+void vecmathRefBatch(vecmath_vec_t *v, u32 count);
+
+/*
+ * Compare SPU results against the reference. Returns the largest relative
+ * error over all outputs (rsqrte is a ~12-bit estimate, so expect ~1e-3).
+ */
+float vecmathRefMaxError(const vecmath_vec_t *v, u32 count);
+
+/* Run soa->op on a SoA batch in double precision; fills every output plane */
+void vecmathRefSoa(vecmath_soa_t *soa);
+
+/* Largest relative error over the output planes selected by soa->flags */
+float vecmathRefSoaMaxError(vecmath_soa_t *soa);
+
+/*
+ * Largest error in ULPs (against the double-precision result rounded to
+ * float) over the selected output planes; the mean goes to 'mean'.
+ */
+u32 vecmathRefSoaUlp(vecmath_soa_t *soa, double *mean);
+
+#endif
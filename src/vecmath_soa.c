@@ -0,0 +1,50 @@
+/*
+ * Structure-of-arrays vecmath batches (see vecmath_soa.h).
+ */
+
+#include <string.h>
+#include <malloc.h>
+
+#include "vecmath_soa.h"
+
+vecmath_soa_t *vecmathSoaAlloc(u32 count, u32 flags)
+{
+    u32 stride = (count + VECMATH_SOA_ALIGN - 1) & ~(VECMATH_SOA_ALIGN - 1);
+    vecmath_soa_t *soa;
+
+    if (!stride)
+        stride = VECMATH_SOA_ALIGN;
+
+    soa = (vecmath_soa_t *)memalign(128, sizeof(vecmath_soa_t) +
+                                         VECMATH_SOA_PLANES * stride * sizeof(float));
+    if (!soa)
+        return NULL;
+
+    memset(soa, 0, sizeof(*soa));
+    soa->count  = count;
+    soa->grain  = count;
+    soa->stride = stride;
+    soa->flags  = flags;
+
+    /* The SPU works in whole quadwords: keep the padding lanes defined */
+    memset(soa + 1, 0, VECMATH_SOA_PLANES * stride * sizeof(float));
+    return soa;
+}
+
+void vecmathSoaFree(vecmath_soa_t *soa)
+{
+    free(soa);
+}
+
+u32 vecmathSoaTraffic(const vecmath_soa_t *soa)
+{
+    u32 planes = 4;     /* x, y, z, w */
+
+    if (soa->flags & VECMATH_SOA_OUT_XYZW)
+        planes += 4;
+    if (soa->flags & VECMATH_SOA_OUT_DOT)
+        planes++;
+    if (soa->flags & VECMATH_SOA_OUT_MAG)
+        planes++;
+    return planes * ((soa->count + 3) & ~3) * sizeof(float);
+}
@@ -0,0 +1,30 @@
+#ifndef __VECMATH_SOA_H__
+#define __VECMATH_SOA_H__
+
+/*
+ * PPU side of the structure-of-arrays batch format (vecmath_soa_t in
+ * vecmath.h): allocation and plane access.
+ */
+#include <ppu-types.h>
+
+#include "vecmath.h"
+
+/*
+ * Allocate a 128-byte aligned batch for 'count' vectors with every plane
+ * padded to a whole number of cache lines. 'flags' selects the output
+ * planes the SPU writes back (VECMATH_SOA_OUT_*).
+ */
+vecmath_soa_t *vecmathSoaAlloc(u32 count, u32 flags);
+
+void vecmathSoaFree(vecmath_soa_t *soa);
+
+/* First float of plane 'plane' (VECMATH_SOA_X .. VECMATH_SOA_MAG) */
+static inline float *vecmathSoaPlane(vecmath_soa_t *soa, u32 plane)
+{
+    return (float *)(soa + 1) + plane * soa->stride;
+}
+
+/* Bytes of main memory the SPU moves for the batch, in and out */
+u32 vecmathSoaTraffic(const vecmath_soa_t *soa);
+
+#endif